@@ -0,0 +1,302 @@
+#include <Geode/Geode.hpp>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "FileAppender.hpp"
+#include "LogFormat.hpp"
+#include "Mailbox.hpp"
+#include "PickerFormat.hpp"
+#include "Sanitizer.hpp"
+#include "Scheduler.hpp"
+#include "Utils.hpp"
+
+/*
+    Native benchmarks for the parts of the mod that run on every log line, every pick or every frame.
+    Results are written as JSON, one entry per benchmark, so runs can be kept and compared:
+
+        SobrietyBench [--quick] [--filter text] [--out file]
+
+    --quick runs every benchmark for a few milliseconds instead of a few hundred, just to check they work.
+*/
+
+struct BenchResult {
+    std::string name;
+    uint64_t iterations;
+    double nanosPerOp;
+    // 0 for benchmarks that aren't about throughput
+    double bytesPerSecond;
+};
+
+class BenchRunner {
+public:
+    BenchRunner(std::chrono::milliseconds minTime, std::string filter) : m_minTime(minTime), m_filter(std::move(filter)) {}
+
+    /*
+        Doubles the batch size until a batch takes at least a tenth of the minimum time, then runs batches
+        of that size until the minimum time is up, so the clock is read far less often than the op runs.
+    */
+    void run(const std::string& name, size_t bytesPerOp, const std::function<void()>& op) {
+        if (!m_filter.empty() && name.find(m_filter) == std::string::npos) return;
+
+        uint64_t batch = 1;
+        while (true) {
+            auto start = std::chrono::steady_clock::now();
+            for (uint64_t i = 0; i < batch; i++) op();
+            if (std::chrono::steady_clock::now() - start >= m_minTime / 10 || batch >= (uint64_t{1} << 30)) break;
+            batch *= 2;
+        }
+
+        uint64_t iterations = 0;
+        auto start = std::chrono::steady_clock::now();
+        std::chrono::steady_clock::duration elapsed;
+        do {
+            for (uint64_t i = 0; i < batch; i++) op();
+            iterations += batch;
+            elapsed = std::chrono::steady_clock::now() - start;
+        } while (elapsed < m_minTime);
+
+        auto nanos = std::chrono::duration<double, std::nano>(elapsed).count();
+        auto& result = m_results.emplace_back(BenchResult{
+            name, iterations, nanos / iterations, bytesPerOp ? bytesPerOp * iterations / (nanos / 1e9) : 0
+        });
+
+        if (result.bytesPerSecond > 0) {
+            fmt::print(stderr, "{:<40} {:>12.1f} ns/op {:>10.2f} GB/s\n", name, result.nanosPerOp, result.bytesPerSecond / 1e9);
+        }
+        else {
+            fmt::print(stderr, "{:<40} {:>12.1f} ns/op\n", name, result.nanosPerOp);
+        }
+    }
+
+    std::string toJson() const {
+        std::string json = "{\n  \"benchmarks\": [\n";
+        for (size_t i = 0; i < m_results.size(); i++) {
+            const auto& result = m_results[i];
+            json += fmt::format("    {{\"name\": \"{}\", \"iterations\": {}, \"ns_per_op\": {:.3f}, \"bytes_per_second\": {:.0f}}}{}\n",
+                result.name, result.iterations, result.nanosPerOp, result.bytesPerSecond, i + 1 < m_results.size() ? "," : ""
+            );
+        }
+        json += "  ]\n}\n";
+        return json;
+    }
+
+private:
+    std::chrono::milliseconds m_minTime;
+    std::string m_filter;
+    std::vector<BenchResult> m_results;
+};
+
+// keeps the compiler from dropping work whose result is never used
+template <class T>
+static void keep(T&& value) {
+    asm volatile("" : : "g"(&value) : "memory");
+}
+
+static std::string makeLine(std::mt19937& rng, size_t length, bool unicode) {
+    static constexpr std::string_view words[] = {
+        "Loaded", "texture", "sheet", "in", "ms", "GJGarageLayer", "level", "12345", "failed", "request", "cache"
+    };
+    static constexpr std::string_view unicodeWords[] = { "niveau", "ñandú", "уровень", "レベル", "🎮" };
+
+    std::string line;
+    while (line.size() < length) {
+        if (unicode && rng() % 4 == 0) line += unicodeWords[rng() % std::size(unicodeWords)];
+        else line += words[rng() % std::size(words)];
+        line += ' ';
+    }
+    // cut back to a whole character so the line stays valid
+    line.resize(length);
+    while (!line.empty() && (static_cast<uint8_t>(line.back()) & 0x80)) line.pop_back();
+    return line;
+}
+
+static void benchPaths(BenchRunner& runner) {
+    setenv("WINEPREFIX", "/home/user/.local/share/Steam/steamapps/compatdata/322170/pfx", 1);
+
+    std::filesystem::path gamePath = "Z:\\home\\user\\.local\\share\\Steam\\steamapps\\common\\Geometry Dash\\GeometryDash.exe";
+    runner.run("wineToLinuxPath/z-drive", 0, [&] {
+        keep(sobriety::utils::wineToLinuxPath(gamePath));
+    });
+
+    std::filesystem::path savePath = "C:\\users\\steamuser\\AppData\\Local\\GeometryDash\\geode\\mods\\alphalaneous.sobriety\\replays";
+    runner.run("wineToLinuxPath/c-drive", 0, [&] {
+        keep(sobriety::utils::wineToLinuxPath(savePath));
+    });
+}
+
+static void benchPicker(BenchRunner& runner) {
+    std::vector<geode::utils::file::FilePickOptions::Filter> filters = {
+        {"Level files", {"*.gmd", "*.gmd2", "*.lvl"}},
+        {"Images", {"*.png", "*.jpg", "*.jpeg", "*.webp"}},
+        {"Audio", {"*.mp3", "*.ogg", "*.wav"}}
+    };
+    runner.run("generateExtensionStrings/3-filters", 0, [&] {
+        keep(sobriety::picker::generateExtensionStrings(filters));
+    });
+
+    std::string single = "/home/user/Documents/levels/Bloodbath.gmd";
+    runner.run("parseSelection/single", 0, [&] {
+        keep(sobriety::picker::parseSelection(single));
+    });
+
+    std::string many;
+    for (int i = 0; i < 64; i++) {
+        if (i) many += '\n';
+        many += fmt::format("/home/user/Music/newgrounds/song-{}.mp3", 100000 + i * 37);
+    }
+    runner.run("parseSelection/64-files", many.size(), [&] {
+        keep(sobriety::picker::parseSelection(many));
+    });
+
+    std::string cancelled = "-1";
+    runner.run("parseSelection/cancelled", 0, [&] {
+        keep(sobriety::picker::parseSelection(cancelled));
+    });
+}
+
+static void benchScheduler(BenchRunner& runner) {
+    auto scheduler = Scheduler::get();
+
+    // a frame at 60fps, with intervals from every frame up to once a minute
+    uint64_t calls = 0;
+    for (int i = 0; i < 1000; i++) {
+        auto interval = std::chrono::milliseconds(i % 10 == 0 ? 0 : (i % 60) * 1000);
+        scheduler->schedule(fmt::format("bench-task-{}", i), [&calls] { calls++; }, interval);
+    }
+    runner.run("Scheduler::update/1000-tasks", 0, [&] {
+        scheduler->update(1.0f / 60.0f);
+    });
+    keep(calls);
+
+    // the same frame with other threads' work waiting in the mailbox, half of it superseding itself
+    uint64_t delivered = 0;
+    runner.run("Scheduler::update/1000-tasks+64-posts", 0, [&] {
+        for (int i = 0; i < 64; i++) {
+            if (i % 2) Mailbox::get()->post([&delivered] { delivered++; });
+            else Mailbox::get()->post(Mailbox::keyFor("bench") + i % 8, [&delivered] { delivered++; });
+        }
+        scheduler->update(1.0f / 60.0f);
+    });
+    keep(delivered);
+
+    for (int i = 0; i < 1000; i++) scheduler->unschedule(fmt::format("bench-task-{}", i));
+}
+
+// The same encodings every line goes through once per sink, built from a line laid out like Geode's.
+static void benchLogFormat(BenchRunner& runner) {
+    std::mt19937 rng(3);
+    auto tagPrefix = "\033[38;5;141m[48213]\033[0m ";
+
+    struct Input {
+        std::string name;
+        std::string line;
+    };
+    std::vector<Input> inputs = {
+        {"120", fmt::format("12:04:51.337 INFO  [Main] [Sobriety]: {}", makeLine(rng, 80, false))},
+        {"4k", fmt::format("12:04:51.337 WARN  [Worker 3] [Sobriety]: {}", makeLine(rng, 4096, true))}
+    };
+
+    for (const auto& input : inputs) {
+        runner.run("logformat::toAnsi/" + input.name, input.line.size(), [&] {
+            keep(sobriety::logformat::toAnsi(geode::Severity::Info, input.line, tagPrefix));
+        });
+        runner.run("logformat::toPlain/" + input.name, input.line.size(), [&] {
+            keep(sobriety::logformat::toPlain(input.line));
+        });
+        runner.run("logformat::toSyslog/" + input.name, input.line.size(), [&] {
+            keep(sobriety::logformat::toSyslog(geode::Severity::Warning, input.line));
+        });
+    }
+}
+
+static void benchFileAppender(BenchRunner& runner) {
+    auto path = std::filesystem::temp_directory_path() / "sobriety-bench-appender.log";
+    std::filesystem::remove(path);
+
+    std::mt19937 rng(7);
+    auto line = makeLine(rng, 119, false) + "\n";
+    {
+        FileAppender appender(path);
+        runner.run("FileAppender::append/120-bytes", line.size(), [&] {
+            appender.append(line);
+        });
+    }
+    std::filesystem::remove(path);
+}
+
+static void benchSanitizer(BenchRunner& runner) {
+    std::mt19937 rng(1);
+
+    struct Input {
+        std::string name;
+        std::string data;
+    };
+    std::vector<Input> inputs = {
+        {"ascii-80", makeLine(rng, 80, false)},
+        {"ascii-64k", makeLine(rng, 64 * 1024, false)},
+        {"utf8-80", makeLine(rng, 80, true)},
+        {"utf8-64k", makeLine(rng, 64 * 1024, true)}
+    };
+
+    bool avx2 = IsProcessorFeaturePresent(PF_AVX2_INSTRUCTIONS_AVAILABLE);
+    for (const auto& input : inputs) {
+        runner.run("sanitizer::isClean/sse2/" + input.name, input.data.size(), [&] {
+            keep(sobriety::sanitizer::isCleanSSE2(input.data));
+        });
+        if (!avx2) continue;
+        runner.run("sanitizer::isClean/avx2/" + input.name, input.data.size(), [&] {
+            keep(sobriety::sanitizer::isCleanAVX2(input.data));
+        });
+    }
+
+    // the slow path, only taken by lines that failed the check
+    auto dirty = makeLine(rng, 80, true);
+    dirty[10] = '\x1b';
+    dirty[40] = '\x07';
+    runner.run("sanitizer::sanitize/dirty-80", dirty.size(), [&] {
+        keep(sobriety::sanitizer::sanitize(dirty));
+    });
+}
+
+int main(int argc, char** argv) {
+    bool quick = false;
+    std::string filter;
+    std::string out;
+
+    for (int i = 1; i < argc; i++) {
+        std::string_view arg = argv[i];
+        if (arg == "--quick") quick = true;
+        else if (arg == "--filter" && i + 1 < argc) filter = argv[++i];
+        else if (arg == "--out" && i + 1 < argc) out = argv[++i];
+        else {
+            fmt::print(stderr, "usage: {} [--quick] [--filter text] [--out file]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    BenchRunner runner(std::chrono::milliseconds(quick ? 5 : 300), filter);
+    benchLogFormat(runner);
+    benchPaths(runner);
+    benchPicker(runner);
+    benchScheduler(runner);
+    benchFileAppender(runner);
+    benchSanitizer(runner);
+
+    auto json = runner.toJson();
+    if (out.empty()) {
+        fmt::print("{}", json);
+        return 0;
+    }
+
+    std::ofstream stream(out, std::ios::out | std::ios::binary | std::ios::trunc);
+    stream << json;
+    if (!stream) {
+        fmt::print(stderr, "Failed to write {}\n", out);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,116 @@
+#include <Geode/Geode.hpp>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <string_view>
+#include "Sanitizer.hpp"
+
+/*
+    Runs random lines through both of the sanitizer's scans and a plain byte by byte reference, and fails on
+    the first line they disagree on. Lines are built from pieces that sit right on the edges of what's valid,
+    and are sized around the 16 and 32 byte blocks the scans work in, where sequences get split.
+
+        SanitizerFuzz [cases] [seed]
+*/
+
+// Written straight from the rules in Sanitizer.hpp, without sharing any code with the scans it checks.
+static bool referenceClean(std::string_view input, bool allowSgr) {
+    auto data = reinterpret_cast<const uint8_t*>(input.data());
+    for (size_t i = 0; i < input.size();) {
+        uint8_t c = data[i];
+
+        if (allowSgr && c == 0x1B && i + 2 < input.size() && input[i + 1] == '[') {
+            size_t j = i + 2;
+            while (j < input.size() && j < i + 32 && ((input[j] >= '0' && input[j] <= '9') || input[j] == ';')) j++;
+            if (j < input.size() && j < i + 32 && input[j] == 'm') {
+                i = j + 1;
+                continue;
+            }
+        }
+
+        if (c < 0x80) {
+            if ((c < 0x20 && c != '\t' && c != '\n') || c == 0x7F) return false;
+            i++;
+            continue;
+        }
+
+        size_t length = c >= 0xF0 ? 4 : c >= 0xE0 ? 3 : c >= 0xC0 ? 2 : 0;
+        if (length == 0 || c > 0xF4 || i + length > input.size()) return false;
+
+        uint32_t codepoint = c & (0x7F >> length);
+        for (size_t j = 1; j < length; j++) {
+            if ((data[i + j] & 0xC0) != 0x80) return false;
+            codepoint = (codepoint << 6) | (data[i + j] & 0x3F);
+        }
+
+        static constexpr uint32_t minimum[] = { 0, 0, 0x80, 0x800, 0x10000 };
+        if (codepoint < minimum[length] || codepoint > 0x10FFFF) return false;
+        if (codepoint >= 0xD800 && codepoint <= 0xDFFF) return false;
+        if (codepoint >= 0x80 && codepoint <= 0x9F) return false;
+        i += length;
+    }
+    return true;
+}
+
+static std::string makeCase(std::mt19937& rng) {
+    static constexpr std::string_view pieces[] = {
+        "a", "Hello ", "\t", "\n", "\x1b", "\x1b[31m", "\x1b[0;1m", "\x1b]0;title\x07", "\x7f", "\x01", "\x1f",
+        "\xc2\xa0", "\xc2\x80", "\xc2\x9f", "\xc3\xa9", "\xc0\xaf", "\xc1\xbf", "\xdf\xbf",
+        "\xe0\xa0\x80", "\xe0\x9f\xbf", "\xe2\x82\xac", "\xed\x9f\xbf", "\xed\xa0\x80", "\xef\xbf\xbd",
+        "\xf0\x90\x80\x80", "\xf0\x8f\xbf\xbf", "\xf4\x8f\xbf\xbf", "\xf4\x90\x80\x80", "\xf5\x80\x80\x80",
+        "\xe2\x82", "\xf0\x9f\x8e", "\x80", "\xbf", "\xff", "\xfe"
+    };
+
+    // mostly long clean runs, so the errors land anywhere inside a block and not just at the start
+    size_t target = rng() % 4 == 0 ? 16 * (rng() % 5) + rng() % 3 : rng() % 300;
+    std::string line;
+    while (line.size() < target) {
+        if (rng() % 3 == 0) line += pieces[rng() % std::size(pieces)];
+        else line += static_cast<char>(0x20 + rng() % 0x5F);
+    }
+
+    // and now and then a byte anywhere, valid or not
+    if (!line.empty() && rng() % 4 == 0) line[rng() % line.size()] = static_cast<char>(rng());
+    return line;
+}
+
+static std::string toHex(std::string_view input) {
+    std::string hex;
+    for (auto c : input) hex += fmt::format("{:02x} ", static_cast<uint8_t>(c));
+    return hex;
+}
+
+int main(int argc, char** argv) {
+    uint64_t cases = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1000000;
+    uint32_t seed = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : std::random_device{}();
+
+    bool avx2 = IsProcessorFeaturePresent(PF_AVX2_INSTRUCTIONS_AVAILABLE);
+    if (!avx2) fmt::print(stderr, "No AVX2 on this CPU, only checking the SSE2 scan\n");
+
+    std::mt19937 rng(seed);
+    uint64_t clean = 0;
+    for (uint64_t i = 0; i < cases; i++) {
+        auto line = makeCase(rng);
+        bool expected = referenceClean(line, false);
+        clean += expected;
+
+        bool sse2 = sobriety::sanitizer::isCleanSSE2(line);
+        bool avx = avx2 ? sobriety::sanitizer::isCleanAVX2(line) : expected;
+        if (sse2 != expected || avx != expected) {
+            fmt::print(stderr, "Mismatch on case {} (seed {}): reference {}, sse2 {}, avx2 {}\n  {}\n",
+                i, seed, expected, sse2, avx, toHex(line)
+            );
+            return 1;
+        }
+
+        // whatever sanitize gives back has to pass, with only its color sequences left in
+        auto sanitized = sobriety::sanitizer::sanitize(line);
+        if (!referenceClean(sanitized, true) || (expected && sanitized != line)) {
+            fmt::print(stderr, "Bad sanitize output on case {} (seed {}):\n  in  {}\n  out {}\n", i, seed, toHex(line), toHex(sanitized));
+            return 1;
+        }
+    }
+
+    fmt::print("{{\"cases\": {}, \"clean\": {}, \"seed\": {}, \"avx2\": {}}}\n", cases, clean, seed, avx2);
+    return 0;
+}
@@ -0,0 +1,57 @@
+#include <Geode/Geode.hpp>
+#include "Config.hpp"
+#include "StallDetector.hpp"
+#include "Trace.hpp"
+
+/*
+    The parts of the mod the benchmarks link against but don't measure. Settings are the defaults, tracing
+    is off like it is unless someone turns it on, and the stall detector only keeps the tick it gets every frame.
+*/
+
+Config::Config() {
+    m_uniquePath = std::filesystem::temp_directory_path() / "sobriety-bench";
+    m_settings.store(std::make_shared<const Settings>());
+}
+
+Config* Config::get() {
+    static Config instance;
+    return &instance;
+}
+
+std::shared_ptr<const Settings> Config::getSettings() {
+    return m_settings.load();
+}
+
+int Config::getFrameReportInterval() {
+    return getSettings()->frameReportInterval;
+}
+
+const std::filesystem::path& Config::getUniquePath() {
+    return m_uniquePath;
+}
+
+std::atomic<bool> Trace::s_enabled = false;
+
+Trace* Trace::get() {
+    static Trace instance;
+    return &instance;
+}
+
+long long Trace::now() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void Trace::record(const TraceEvent&) {}
+
+StallDetector* StallDetector::get() {
+    static StallDetector instance;
+    return &instance;
+}
+
+long long StallDetector::now() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void StallDetector::tick() {
+    m_lastTick.store(now(), std::memory_order_relaxed);
+}
@@ -0,0 +1,59 @@
+#!/bin/bash
+
+# Runs picks through the real hooks in the game, with stand-in pickers and a stand-in terminal from stubs/ first
+# on PATH, and prints the latency of each stage once they're done.
+#
+#   bench/latency/run.sh [-n picks] [-d picker delay] [-w load wait] -- <command that starts the game>
+#
+# e.g. bench/latency/run.sh -n 50 -d 0.1 -- steam -applaunch 322170
+#
+# The console has to be turned on in the mod's settings, the command goes in and the results come back through it.
+
+HERE="$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)"
+PICKS=20
+DELAY=0.05
+WAIT=5
+TIMEOUT=300
+
+usage() {
+    echo "usage: $0 [-n picks] [-d picker delay] [-w load wait] -- <command that starts the game>" >&2
+    exit 2
+}
+
+while getopts "n:d:w:" OPT; do
+    case "$OPT" in
+        n) PICKS="$OPTARG" ;;
+        d) DELAY="$OPTARG" ;;
+        w) WAIT="$OPTARG" ;;
+        *) usage ;;
+    esac
+done
+shift $((OPTIND - 1))
+[ "$1" = "--" ] && shift
+[ $# -eq 0 ] && usage
+
+OUT="$(mktemp -d)"
+: > "$OUT/picked.txt"
+
+export PATH="$HERE/stubs:$PATH"
+export XDG_CURRENT_DESKTOP="GNOME"
+export SOBRIETY_STUB_DELAY="$DELAY"
+export SOBRIETY_STUB_RESULT="${SOBRIETY_STUB_RESULT:-$OUT/picked.txt}"
+export SOBRIETY_STUB_WAIT="$WAIT"
+export SOBRIETY_STUB_PICKS="$PICKS"
+export SOBRIETY_STUB_OUT="$OUT"
+
+"$@" &
+
+# the results are the reply line and one line per stage after it
+DEADLINE=$(( $(date +%s) + TIMEOUT ))
+until grep -q "latency after $PICKS picks" "$OUT/console.log" 2>/dev/null; do
+    if [ "$(date +%s)" -ge "$DEADLINE" ]; then
+        echo "No results after ${TIMEOUT}s, the console output so far is in $OUT/console.log" >&2
+        exit 1
+    fi
+    sleep 1
+done
+sleep 1
+
+sed 's/\x1b\[[0-9;]*m//g' "$OUT/console.log" | grep -A 5 "latency after $PICKS picks" | sed 's/^.*\[console\] //'
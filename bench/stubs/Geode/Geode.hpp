@@ -0,0 +1,18 @@
+#pragma once
+
+#include <Geode/Result.hpp>
+#include <Geode/cocos/base_nodes/CCNode.h>
+#include <Geode/loader/Log.hpp>
+#include <Geode/loader/Mod.hpp>
+#include <Geode/utils/file.hpp>
+#include <Geode/utils/string.hpp>
+#include <windows.h>
+#include <climits>
+
+// Nothing is loaded in the benchmarks, so a $on_mod block is compiled and never run.
+#define $on_mod(type) [[maybe_unused]] static void onMod##type()
+
+namespace geode::prelude {
+    using namespace ::geode;
+    using namespace ::cocos2d;
+}
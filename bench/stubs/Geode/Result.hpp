@@ -0,0 +1,46 @@
+#pragma once
+
+#include <string>
+#include <utility>
+
+// Just enough of geode::Result for the code the benchmarks build, an error is always a string.
+namespace geode {
+    template <class T = void>
+    class Result {
+    public:
+        static Result ok(T value) { return Result(std::move(value), {}, true); }
+        static Result err(std::string error) { return Result({}, std::move(error), false); }
+
+        explicit operator bool() const { return m_ok; }
+        bool isOk() const { return m_ok; }
+        bool isErr() const { return !m_ok; }
+        T& unwrap() & { return m_value; }
+        T unwrap() && { return std::move(m_value); }
+        const std::string& unwrapErr() const { return m_error; }
+
+    private:
+        Result(T value, std::string error, bool ok) : m_value(std::move(value)), m_error(std::move(error)), m_ok(ok) {}
+
+        T m_value;
+        std::string m_error;
+        bool m_ok;
+    };
+
+    template <>
+    class Result<void> {
+    public:
+        static Result ok() { return Result({}, true); }
+        static Result err(std::string error) { return Result(std::move(error), false); }
+
+        explicit operator bool() const { return m_ok; }
+        bool isOk() const { return m_ok; }
+        bool isErr() const { return !m_ok; }
+        const std::string& unwrapErr() const { return m_error; }
+
+    private:
+        Result(std::string error, bool ok) : m_error(std::move(error)), m_ok(ok) {}
+
+        std::string m_error;
+        bool m_ok;
+    };
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdint>
+
+namespace cocos2d {
+    struct ccColor3B {
+        uint8_t r = 0;
+        uint8_t g = 0;
+        uint8_t b = 0;
+    };
+
+    // Nodes are never drawn here, the Scheduler only needs to be one.
+    class CCNode {
+    public:
+        virtual ~CCNode() = default;
+
+        virtual bool init() { return true; }
+        virtual void onEnter() {}
+        void autorelease() {}
+    };
+
+    class CCScheduler {
+    public:
+        static CCScheduler* get() {
+            static CCScheduler instance;
+            return &instance;
+        }
+
+        void scheduleUpdateForTarget(CCNode*, int, bool) {}
+    };
+
+    class CCDirector {
+    public:
+        static CCDirector* get() {
+            static CCDirector instance;
+            return &instance;
+        }
+
+        double getAnimationInterval() { return 1.0 / 60.0; }
+    };
+}
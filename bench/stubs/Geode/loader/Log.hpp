@@ -0,0 +1,20 @@
+#pragma once
+
+#include <fmt/format.h>
+
+namespace geode {
+    enum class Severity {
+        Debug,
+        Info,
+        Warning,
+        Error
+    };
+
+    // The benchmarks measure the code around the logging, not the logging, so every line is thrown away.
+    namespace log {
+        template <class... Args> void debug(Args&&...) {}
+        template <class... Args> void info(Args&&...) {}
+        template <class... Args> void warn(Args&&...) {}
+        template <class... Args> void error(Args&&...) {}
+    }
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <Geode/Result.hpp>
+#include <Geode/cocos/base_nodes/CCNode.h>
+#include <Geode/loader/Log.hpp>
+#include <string>
+
+namespace geode {
+    class Mod {
+    public:
+        const std::string& getID() const { return m_id; }
+
+    private:
+        std::string m_id = "bench";
+    };
+}
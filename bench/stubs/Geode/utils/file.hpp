@@ -0,0 +1,39 @@
+#pragma once
+
+#include <Geode/Result.hpp>
+#include <Geode/utils/string.hpp>
+#include <charconv>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace geode::utils {
+    template <class T>
+    Result<T> numFromString(std::string_view str) {
+        T value{};
+        auto [end, ec] = std::from_chars(str.data(), str.data() + str.size(), value);
+        if (ec != std::errc() || end != str.data() + str.size()) return Result<T>::err("not a number");
+        return Result<T>::ok(value);
+    }
+}
+
+namespace geode::utils::file {
+    struct FilePickOptions {
+        struct Filter {
+            std::string description;
+            std::unordered_set<std::string> files;
+        };
+
+        std::optional<std::filesystem::path> defaultPath;
+        std::vector<Filter> filters;
+    };
+
+    inline Result<> createDirectoryAll(const std::filesystem::path& path) {
+        std::error_code ec;
+        std::filesystem::create_directories(path, ec);
+        if (ec) return Result<>::err(ec.message());
+        return Result<>::ok();
+    }
+}
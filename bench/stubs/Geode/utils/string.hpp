@@ -0,0 +1,35 @@
+#pragma once
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace geode::utils::string {
+    inline std::string pathToString(const std::filesystem::path& path) {
+        return path.string();
+    }
+
+    inline std::string& trimIP(std::string& str) {
+        constexpr auto whitespace = " \t\n\r\f\v";
+        str.erase(str.find_last_not_of(whitespace) + 1);
+        str.erase(0, std::min(str.find_first_not_of(whitespace), str.size()));
+        return str;
+    }
+
+    inline std::string trim(const std::string& str) {
+        auto copy = str;
+        return trimIP(copy);
+    }
+
+    inline std::vector<std::string> split(const std::string& str, const std::string& separator) {
+        std::vector<std::string> parts;
+        size_t start = 0;
+        size_t end;
+        while ((end = str.find(separator, start)) != std::string::npos) {
+            parts.push_back(str.substr(start, end - start));
+            start = end + separator.size();
+        }
+        parts.push_back(str.substr(start));
+        return parts;
+    }
+}
@@ -0,0 +1,11 @@
+#pragma once
+
+#include <ctime>
+
+namespace asp {
+    inline std::tm localtime(std::time_t time) {
+        std::tm result{};
+        localtime_r(&time, &result);
+        return result;
+    }
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+
+/*
+    The few Win32 names the portable code still touches. Nothing here starts a process or looks up a module,
+    and processor features come from the compiler instead of the kernel.
+*/
+using BOOL = int;
+using DWORD = uint32_t;
+using WORD = uint16_t;
+using HANDLE = void*;
+using HMODULE = void*;
+using FARPROC = void (*)();
+using LPSTR = char*;
+
+#define FALSE 0
+#define TRUE 1
+#define STARTF_USESHOWWINDOW 0x1
+#define SW_HIDE 0
+#define CREATE_NO_WINDOW 0x08000000
+#define PF_AVX2_INSTRUCTIONS_AVAILABLE 40
+
+struct STARTUPINFOA {
+    DWORD cb;
+    DWORD dwFlags;
+    WORD wShowWindow;
+};
+
+struct PROCESS_INFORMATION {
+    HANDLE hProcess;
+    HANDLE hThread;
+};
+
+inline BOOL CreateProcessA(const char*, char*, void*, void*, BOOL, DWORD, void*, const char*, STARTUPINFOA*, PROCESS_INFORMATION*) {
+    return FALSE;
+}
+
+inline BOOL CloseHandle(HANDLE) { return TRUE; }
+inline HMODULE GetModuleHandleA(const char*) { return nullptr; }
+inline FARPROC GetProcAddress(HMODULE, const char*) { return nullptr; }
+
+inline BOOL IsProcessorFeaturePresent(DWORD feature) {
+    if (feature == PF_AVX2_INSTRUCTIONS_AVAILABLE) return __builtin_cpu_supports("avx2");
+    return FALSE;
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <Geode/loader/Dispatch.hpp>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <string>
+
+// the exports below need Sobriety's id, the includer's own MY_MOD_ID comes back at the end of the file
+#pragma push_macro("MY_MOD_ID")
+#ifdef MY_MOD_ID
+    #undef MY_MOD_ID
+#endif
+#define MY_MOD_ID "alphalaneous.sobriety"
+
+/*
+    Lets other mods watch a directory through Sobriety's watcher instead of starting their own.
+    Every subscriber to the same directory shares one watcher thread and one kernel watch.
+
+    auto res = sobriety::watch::subscribe({
+        .directory = Mod::get()->getConfigDir(),
+        .pattern = "*.json",
+        .debounce = std::chrono::milliseconds(200)
+    }, [](std::filesystem::path const& path) {
+        log::info("{} changed", path);
+    });
+*/
+namespace sobriety::watch {
+
+    enum class Delivery {
+        // queued onto the main thread, so it is safe to touch nodes
+        MainThread,
+        // called straight from the watcher's delivery thread, keep it short
+        Worker
+    };
+
+    struct WatchOptions {
+        std::filesystem::path directory;
+        // matched against the path relative to the directory with forward slashes.
+        // * and ? stay within one folder, ** crosses folders
+        std::string pattern = "**";
+        // changes to the same file within this window are delivered once, after it passes.
+        // each file has its own window, a busy file doesn't hold back the others
+        std::chrono::milliseconds debounce = std::chrono::milliseconds(0);
+        Delivery delivery = Delivery::MainThread;
+    };
+
+    // Called once per changed path, with the full path to it.
+    using WatchCallback = std::function<void(std::filesystem::path const&)>;
+
+    // Returns an id to unsubscribe with.
+    inline geode::Result<uint64_t> subscribe(WatchOptions options, WatchCallback callback)
+        GEODE_EVENT_EXPORT(&subscribe, (std::move(options), std::move(callback)));
+
+    // Waits for a callback that's already running, after this nothing it captured is touched again.
+    inline geode::Result<> unsubscribe(uint64_t id)
+        GEODE_EVENT_EXPORT(&unsubscribe, (id));
+}
+
+#pragma pop_macro("MY_MOD_ID")
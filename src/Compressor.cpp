@@ -0,0 +1,142 @@
+#include "Compressor.hpp"
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+
+namespace sobriety::compressor {
+
+static constexpr size_t MIN_MATCH = 4;
+static constexpr size_t MAX_OFFSET = 65535;
+static constexpr size_t HASH_BITS = 12;
+// The format requires the last bytes to be literals, so matches never run into the end of the input.
+static constexpr size_t END_LITERALS = 5;
+
+static uint32_t read32(const char* ptr) {
+    uint32_t value;
+    std::memcpy(&value, ptr, sizeof(value));
+    return value;
+}
+
+static uint32_t hash(uint32_t value) {
+    return (value * 2654435761u) >> (32 - HASH_BITS);
+}
+
+static void writeLength(std::string& out, size_t length) {
+    while (length >= 255) {
+        out += static_cast<char>(255);
+        length -= 255;
+    }
+    out += static_cast<char>(length);
+}
+
+static void writeSequence(std::string& out, std::string_view literals, size_t offset, size_t matchLength) {
+    size_t literalLength = literals.size();
+    size_t matchCode = matchLength >= MIN_MATCH ? matchLength - MIN_MATCH : 0;
+
+    auto token = static_cast<uint8_t>((std::min<size_t>(literalLength, 15) << 4) | std::min<size_t>(matchCode, 15));
+    out += static_cast<char>(token);
+
+    if (literalLength >= 15) writeLength(out, literalLength - 15);
+    out.append(literals);
+
+    if (matchLength < MIN_MATCH) return;
+
+    out += static_cast<char>(offset & 0xFF);
+    out += static_cast<char>((offset >> 8) & 0xFF);
+
+    if (matchCode >= 15) writeLength(out, matchCode - 15);
+}
+
+std::string compress(std::string_view input) {
+    std::string out;
+    out.reserve(input.size() / 2 + 16);
+
+    std::array<uint32_t, 1 << HASH_BITS> table;
+    table.fill(UINT32_MAX);
+
+    const char* data = input.data();
+    size_t size = input.size();
+    size_t anchor = 0;
+    size_t pos = 0;
+
+    if (size > MIN_MATCH + END_LITERALS) {
+        size_t limit = size - END_LITERALS;
+
+        while (pos + MIN_MATCH <= limit) {
+            uint32_t sequence = read32(data + pos);
+            auto& entry = table[hash(sequence)];
+            size_t candidate = entry;
+            entry = static_cast<uint32_t>(pos);
+
+            if (candidate == UINT32_MAX || pos - candidate > MAX_OFFSET || read32(data + candidate) != sequence) {
+                pos++;
+                continue;
+            }
+
+            size_t length = MIN_MATCH;
+            while (pos + length < limit && data[candidate + length] == data[pos + length]) {
+                length++;
+            }
+
+            writeSequence(out, input.substr(anchor, pos - anchor), pos - candidate, length);
+
+            pos += length;
+            anchor = pos;
+        }
+    }
+
+    writeSequence(out, input.substr(anchor), 0, 0);
+    return out;
+}
+
+static bool readLength(std::string_view input, size_t& pos, size_t& length) {
+    uint8_t byte;
+    do {
+        if (pos >= input.size()) return false;
+        byte = static_cast<uint8_t>(input[pos++]);
+        length += byte;
+    } while (byte == 255);
+    return true;
+}
+
+std::optional<std::string> decompress(std::string_view input, size_t rawSize) {
+    std::string out;
+    out.reserve(rawSize);
+
+    size_t pos = 0;
+    while (pos < input.size()) {
+        auto token = static_cast<uint8_t>(input[pos++]);
+
+        size_t literalLength = token >> 4;
+        if (literalLength == 15 && !readLength(input, pos, literalLength)) return std::nullopt;
+        if (pos + literalLength > input.size()) return std::nullopt;
+
+        out.append(input.substr(pos, literalLength));
+        pos += literalLength;
+
+        // the last sequence has no match
+        if (pos == input.size()) break;
+
+        if (pos + 2 > input.size()) return std::nullopt;
+        size_t offset = static_cast<uint8_t>(input[pos]) | (static_cast<uint8_t>(input[pos + 1]) << 8);
+        pos += 2;
+
+        size_t matchLength = token & 0xF;
+        if (matchLength == 15 && !readLength(input, pos, matchLength)) return std::nullopt;
+        matchLength += MIN_MATCH;
+
+        if (offset == 0 || offset > out.size() || out.size() + matchLength > rawSize) return std::nullopt;
+
+        // matches can overlap what they are copying, so this has to go byte by byte
+        size_t start = out.size() - offset;
+        for (size_t i = 0; i < matchLength; i++) {
+            out += out[start + i];
+        }
+    }
+
+    if (out.size() != rawSize) return std::nullopt;
+    return out;
+}
+
+}
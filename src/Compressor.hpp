@@ -0,0 +1,14 @@
+#pragma once
+
+#include <optional>
+#include <string>
+#include <string_view>
+
+/*
+    A small LZ77 compressor using the LZ4 block layout. Console output is mostly the same escape sequences,
+    timestamps and mod names over and over, so even this greedy single pass gets most of the way there.
+*/
+namespace sobriety::compressor {
+    std::string compress(std::string_view input);
+    std::optional<std::string> decompress(std::string_view input, size_t rawSize);
+}
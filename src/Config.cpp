@@ -1,6 +1,10 @@
 #include <Geode/Geode.hpp>
 #include "Config.hpp"
 #include "Console.hpp"
+#include "FrameProfiler.hpp"
+#include "LogReplay.hpp"
+#include "PerformanceOverlay.hpp"
+#include "Trace.hpp"
 #include "Utils.hpp"
 
 using namespace geode::prelude;
@@ -16,99 +20,280 @@ Config::Config() {
     auto now = std::chrono::system_clock::now();
     auto nowMs = std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()).count();
     m_uniquePath = std::filesystem::path(fmt::format("/tmp/GeometryDash-{}/", nowMs));
+
+    auto settings = std::make_shared<Settings>();
+    settings->consoleLogLevel = sobriety::utils::fromString(m_geode->getSettingValue<std::string>("console-log-level"));
+    settings->logMilliseconds = m_geode->getSettingValue<bool>("log-milliseconds");
+    settings->hasConsole = m_geode->getSettingValue<bool>("show-platform-console");
+    settings->heartbeatThreshold = m_mod->getSettingValue<int>("console-heartbeat-threshold");
+    settings->fontSize = m_mod->getSettingValue<int>("console-font-size");
+    settings->terminal = m_mod->getSettingValue<std::string>("console-terminal");
+    settings->consoleOpenMode = m_mod->getSettingValue<std::string>("console-open-mode");
+    settings->consoleShared = m_mod->getSettingValue<bool>("console-shared");
+    settings->consoleArchive = m_mod->getSettingValue<bool>("console-archive");
+    settings->consoleForegroundColor = m_mod->getSettingValue<ccColor3B>("console-foreground-color");
+    settings->consoleBackgroundColor = m_mod->getSettingValue<ccColor3B>("console-background-color");
+    settings->logInfoColor = m_mod->getSettingValue<ccColor3B>("console-log-info-color");
+    settings->logWarnColor = m_mod->getSettingValue<ccColor3B>("console-log-warn-color");
+    settings->logErrorColor = m_mod->getSettingValue<ccColor3B>("console-log-error-color");
+    settings->logDebugColor = m_mod->getSettingValue<ccColor3B>("console-log-debug-color");
+    settings->performanceOverlay = m_mod->getSettingValue<bool>("performance-overlay");
+    settings->traceEnabled = m_mod->getSettingValue<bool>("trace-enabled");
+    settings->recordLogs = m_mod->getSettingValue<bool>("log-record");
+    settings->stallBudget = m_mod->getSettingValue<int>("stall-budget");
+    settings->frameReportInterval = m_mod->getSettingValue<int>("frame-report-interval");
+    settings->mainThreadBudget = m_mod->getSettingValue<int>("main-thread-budget");
+    settings->messageCap = static_cast<size_t>(m_mod->getSettingValue<int>("log-message-cap")) * 1024;
+    settings->spillOversized = m_mod->getSettingValue<bool>("log-spill-oversized");
+    settings->helperAffinity = sobriety::utils::parseCpuList(m_mod->getSettingValue<std::string>("helper-cpus"));
+    settings->logFileEnabled = m_mod->getSettingValue<bool>("console-log-file");
+    settings->logFileLevel = sobriety::utils::fromString(m_mod->getSettingValue<std::string>("console-log-file-level"));
+    settings->syslogEnabled = m_mod->getSettingValue<bool>("console-syslog");
+    settings->syslogLevel = sobriety::utils::fromString(m_mod->getSettingValue<std::string>("console-syslog-level"));
+    settings->loopbackPort = m_mod->getSettingValue<int>("console-loopback-port");
+    settings->loopbackLevel = sobriety::utils::fromString(m_mod->getSettingValue<std::string>("console-loopback-level"));
+
+    m_settings.store(std::move(settings));
+
+    setupListeners();
 }
 
-Severity Config::getConsoleLogLevel() {
-    static auto setting = sobriety::utils::fromString(m_geode->getSettingValue<std::string>("console-log-level"));
-    static auto listener = listenForSettingChanges<std::string>("console-log-level", [](std::string value) {
-        setting = sobriety::utils::fromString(value);
+/*
+    Listeners fire on the main thread, so publishing never races with itself. 
+    Font size, terminal, console sharing, archiving, the extra log sinks, helper CPUs and the platform console toggle require a restart,
+    so they are only read once. Sink levels can change at any time since each sink checks them per line.
+*/
+void Config::setupListeners() {
+    static auto logLevelListener = listenForSettingChanges<std::string>("console-log-level", [this](std::string value) {
+        publish([value = std::move(value)](Settings& settings) {
+            settings.consoleLogLevel = sobriety::utils::fromString(value);
+        });
+    }, m_geode);
+
+    static auto millisecondsListener = listenForSettingChanges<bool>("log-milliseconds", [this](bool value) {
+        publish([value](Settings& settings) {
+            settings.logMilliseconds = value;
+        });
     }, m_geode);
 
-    return setting;
+    static auto openModeListener = listenForSettingChanges<std::string>("console-open-mode", [this](std::string value) {
+        bool always = value == "always";
+        publish([value = std::move(value)](Settings& settings) {
+            settings.consoleOpenMode = value;
+        });
+        if (always) Console::get()->requestOpen();
+    });
+
+    static auto heartbeatListener = listenForSettingChanges<int>("console-heartbeat-threshold", [this](int value) {
+        publish([value](Settings& settings) {
+            settings.heartbeatThreshold = value;
+        });
+    });
+
+    static auto foregroundListener = listenForSettingChanges<ccColor3B>("console-foreground-color", [this](ccColor3B value) {
+        publish([value](Settings& settings) {
+            settings.consoleForegroundColor = value;
+        });
+        Console::get()->setConsoleColors();
+    });
+
+    static auto backgroundListener = listenForSettingChanges<ccColor3B>("console-background-color", [this](ccColor3B value) {
+        publish([value](Settings& settings) {
+            settings.consoleBackgroundColor = value;
+        });
+        Console::get()->setConsoleColors();
+    });
+
+    static auto infoListener = listenForSettingChanges<ccColor3B>("console-log-info-color", [this](ccColor3B value) {
+        publish([value](Settings& settings) {
+            settings.logInfoColor = value;
+        });
+        Console::get()->setConsoleColors();
+    });
+
+    static auto warnListener = listenForSettingChanges<ccColor3B>("console-log-warn-color", [this](ccColor3B value) {
+        publish([value](Settings& settings) {
+            settings.logWarnColor = value;
+        });
+        Console::get()->setConsoleColors();
+    });
+
+    static auto errorListener = listenForSettingChanges<ccColor3B>("console-log-error-color", [this](ccColor3B value) {
+        publish([value](Settings& settings) {
+            settings.logErrorColor = value;
+        });
+        Console::get()->setConsoleColors();
+    });
+
+    static auto debugListener = listenForSettingChanges<ccColor3B>("console-log-debug-color", [this](ccColor3B value) {
+        publish([value](Settings& settings) {
+            settings.logDebugColor = value;
+        });
+        Console::get()->setConsoleColors();
+    });
+
+    static auto overlayListener = listenForSettingChanges<bool>("performance-overlay", [this](bool value) {
+        publish([value](Settings& settings) {
+            settings.performanceOverlay = value;
+        });
+        PerformanceOverlay::setEnabled(value);
+    });
+
+    static auto stallBudgetListener = listenForSettingChanges<int>("stall-budget", [this](int value) {
+        publish([value](Settings& settings) {
+            settings.stallBudget = value;
+        });
+    });
+
+    static auto frameReportListener = listenForSettingChanges<int>("frame-report-interval", [this](int value) {
+        publish([value](Settings& settings) {
+            settings.frameReportInterval = value;
+        });
+        FrameProfiler::get()->setup();
+    });
+
+    static auto traceListener = listenForSettingChanges<bool>("trace-enabled", [this](bool value) {
+        publish([value](Settings& settings) {
+            settings.traceEnabled = value;
+        });
+        Trace::get()->setEnabled(value);
+    });
+
+    static auto mainThreadBudgetListener = listenForSettingChanges<int>("main-thread-budget", [this](int value) {
+        publish([value](Settings& settings) {
+            settings.mainThreadBudget = value;
+        });
+    });
+
+    static auto recordListener = listenForSettingChanges<bool>("log-record", [this](bool value) {
+        publish([value](Settings& settings) {
+            settings.recordLogs = value;
+        });
+        LogReplay::get()->setRecording(value);
+    });
+
+    static auto messageCapListener = listenForSettingChanges<int>("log-message-cap", [this](int value) {
+        publish([value](Settings& settings) {
+            settings.messageCap = static_cast<size_t>(value) * 1024;
+        });
+    });
+
+    static auto spillListener = listenForSettingChanges<bool>("log-spill-oversized", [this](bool value) {
+        publish([value](Settings& settings) {
+            settings.spillOversized = value;
+        });
+    });
+
+    static auto logFileLevelListener = listenForSettingChanges<std::string>("console-log-file-level", [this](std::string value) {
+        publish([value = std::move(value)](Settings& settings) {
+            settings.logFileLevel = sobriety::utils::fromString(value);
+        });
+    });
+
+    static auto syslogLevelListener = listenForSettingChanges<std::string>("console-syslog-level", [this](std::string value) {
+        publish([value = std::move(value)](Settings& settings) {
+            settings.syslogLevel = sobriety::utils::fromString(value);
+        });
+    });
+
+    static auto loopbackLevelListener = listenForSettingChanges<std::string>("console-loopback-level", [this](std::string value) {
+        publish([value = std::move(value)](Settings& settings) {
+            settings.loopbackLevel = sobriety::utils::fromString(value);
+        });
+    });
 }
 
-bool Config::shouldLogMillisconds() {
-    static auto setting = m_geode->getSettingValue<bool>("log-milliseconds");
-    static auto listener = listenForSettingChanges<bool>("log-milliseconds", [](bool value) {
-        setting = value;
-    }, m_geode);
+void Config::publish(std::function<void(Settings&)>&& change) {
+    auto settings = std::make_shared<Settings>(*getSettings());
+    change(*settings);
 
-    return setting;
+    m_settings.store(std::move(settings));
 }
 
-int Config::getHeartbeatThreshold() {
-    static auto setting = m_mod->getSettingValue<int>("console-heartbeat-threshold");
-    static auto listener = listenForSettingChanges<int>("console-heartbeat-threshold", [](int value) {
-        setting = value;
-    });
+std::shared_ptr<const Settings> Config::getSettings() {
+    return m_settings.load();
+}
+
+Severity Config::getConsoleLogLevel() {
+    return getSettings()->consoleLogLevel;
+}
 
-    return setting;
+bool Config::shouldLogMillisconds() {
+    return getSettings()->logMilliseconds;
+}
+
+int Config::getHeartbeatThreshold() {
+    return getSettings()->heartbeatThreshold;
 }
 
 int Config::getFontSize() {
-    static auto setting = m_mod->getSettingValue<int>("console-font-size");
-    return setting;
+    return getSettings()->fontSize;
+}
+
+std::string Config::getTerminal() {
+    return getSettings()->terminal;
+}
+
+std::string Config::getConsoleOpenMode() {
+    return getSettings()->consoleOpenMode;
+}
+
+bool Config::isConsoleShared() {
+    return getSettings()->consoleShared;
+}
+
+bool Config::shouldArchiveConsole() {
+    return getSettings()->consoleArchive;
 }
 
 cocos2d::ccColor3B Config::getConsoleForegroundColor() {
-    static auto setting = m_mod->getSettingValue<ccColor3B>("console-foreground-color");
-    static auto listener = listenForSettingChanges<ccColor3B>("console-foreground-color", [](ccColor3B value) {
-        setting = value;
-        Console::get()->setConsoleColors();
-    });
-    return setting;
+    return getSettings()->consoleForegroundColor;
 }
 
 cocos2d::ccColor3B Config::getConsoleBackgroundColor() {
-    static auto setting = m_mod->getSettingValue<ccColor3B>("console-background-color");
-    static auto listener = listenForSettingChanges<ccColor3B>("console-background-color", [](ccColor3B value) {
-        setting = value;
-        Console::get()->setConsoleColors();
-    });
-    return setting;
+    return getSettings()->consoleBackgroundColor;
 }
 
 cocos2d::ccColor3B Config::getLogInfoColor() {
-    static auto setting = m_mod->getSettingValue<ccColor3B>("console-log-info-color");
-    static auto listener = listenForSettingChanges<ccColor3B>("console-log-info-color", [](ccColor3B value) {
-        setting = value;
-        Console::get()->setConsoleColors();
-    });
-    return setting;
+    return getSettings()->logInfoColor;
 }
 
 cocos2d::ccColor3B Config::getLogWarnColor() {
-    static auto setting = m_mod->getSettingValue<ccColor3B>("console-log-warn-color");
-    static auto listener = listenForSettingChanges<ccColor3B>("console-log-warn-color", [](ccColor3B value) {
-        setting = value;
-        Console::get()->setConsoleColors();
-    });
-    return setting;
+    return getSettings()->logWarnColor;
 }
 
 cocos2d::ccColor3B Config::getLogErrorColor() {
-    static auto setting = m_mod->getSettingValue<ccColor3B>("console-log-error-color");
-    static auto listener = listenForSettingChanges<ccColor3B>("console-log-error-color", [](ccColor3B value) {
-        setting = value;
-        Console::get()->setConsoleColors();
-    });
-    return setting;
+    return getSettings()->logErrorColor;
 }
 
 cocos2d::ccColor3B Config::getLogDebugColor() {
-    static auto setting = m_mod->getSettingValue<ccColor3B>("console-log-debug-color");
-    static auto listener = listenForSettingChanges<ccColor3B>("console-log-debug-color", [](ccColor3B value) {
-        setting = value;
-        Console::get()->setConsoleColors();
-    });
-    return setting;
+    return getSettings()->logDebugColor;
+}
+
+bool Config::showPerformanceOverlay() {
+    return getSettings()->performanceOverlay;
+}
+
+bool Config::isTraceEnabled() {
+    return getSettings()->traceEnabled;
+}
+
+int Config::getStallBudget() {
+    return getSettings()->stallBudget;
+}
+
+int Config::getFrameReportInterval() {
+    return getSettings()->frameReportInterval;
+}
+
+uint64_t Config::getHelperAffinity() {
+    return getSettings()->helperAffinity;
 }
 
 bool Config::hasConsole() {
-    static bool setting = m_geode->getSettingValue<bool>("show-platform-console");
-    return setting;
+    return getSettings()->hasConsole;
 }
 
 const std::filesystem::path& Config::getUniquePath() {
     return m_uniquePath;
-}
\ No newline at end of file
+}
@@ -1,7 +1,48 @@
 #pragma once
 
 #include <Geode/loader/Mod.hpp>
+#include <atomic>
 #include <filesystem>
+#include <functional>
+#include <memory>
+#include <string>
+
+/*
+    An immutable copy of every setting the mod reads. Readers on any thread grab the current
+    snapshot with a single atomic load, so a log line or heartbeat check always sees one consistent set.
+*/
+struct Settings {
+    geode::Severity consoleLogLevel = geode::Severity::Info;
+    bool logMilliseconds = false;
+    int heartbeatThreshold = 1000;
+    int fontSize = 10;
+    std::string terminal = "auto";
+    std::string consoleOpenMode = "always";
+    bool consoleShared = false;
+    bool consoleArchive = false;
+    bool hasConsole = false;
+    cocos2d::ccColor3B consoleForegroundColor;
+    cocos2d::ccColor3B consoleBackgroundColor;
+    cocos2d::ccColor3B logInfoColor;
+    cocos2d::ccColor3B logWarnColor;
+    cocos2d::ccColor3B logErrorColor;
+    cocos2d::ccColor3B logDebugColor;
+    bool performanceOverlay = false;
+    bool traceEnabled = false;
+    bool recordLogs = false;
+    int stallBudget = 0;
+    int frameReportInterval = 0;
+    int mainThreadBudget = 2000;
+    uint64_t helperAffinity = 0;
+    size_t messageCap = 64 * 1024;
+    bool spillOversized = false;
+    bool logFileEnabled = false;
+    geode::Severity logFileLevel = geode::Severity::Info;
+    bool syslogEnabled = false;
+    geode::Severity syslogLevel = geode::Severity::Warning;
+    int loopbackPort = 0;
+    geode::Severity loopbackLevel = geode::Severity::Debug;
+};
 
 class Config {
 public:
@@ -9,10 +50,16 @@ public:
 
     static Config* get();
 
+    std::shared_ptr<const Settings> getSettings();
+
     geode::Severity getConsoleLogLevel();
     bool shouldLogMillisconds();
     int getHeartbeatThreshold();
     int getFontSize();
+    std::string getTerminal();
+    std::string getConsoleOpenMode();
+    bool isConsoleShared();
+    bool shouldArchiveConsole();
     bool hasConsole();
     cocos2d::ccColor3B getConsoleForegroundColor();
     cocos2d::ccColor3B getConsoleBackgroundColor();
@@ -20,11 +67,22 @@ public:
     cocos2d::ccColor3B getLogWarnColor();
     cocos2d::ccColor3B getLogErrorColor();
     cocos2d::ccColor3B getLogDebugColor();
+    bool showPerformanceOverlay();
+    bool isTraceEnabled();
+    int getStallBudget();
+    int getFrameReportInterval();
+    uint64_t getHelperAffinity();
 
     const std::filesystem::path& getUniquePath();
 
 private:
+    void setupListeners();
+    void publish(std::function<void(Settings&)>&& change);
+
     geode::Mod* m_geode = nullptr;
     geode::Mod* m_mod = nullptr;
     std::filesystem::path m_uniquePath;
-};
\ No newline at end of file
+
+    // a reader keeps its snapshot alive for as long as it holds it, the old one goes with the last reader
+    std::atomic<std::shared_ptr<const Settings>> m_settings;
+};
@@ -1,9 +1,22 @@
 #include <Geode/Geode.hpp>
+#include <fmt/chrono.h>
 #include "Console.hpp"
 #include "FileAppender.hpp"
 #include "Utils.hpp"
 #include "Config.hpp"
+#include "ConsoleControl.hpp"
 #include "FileWatcher.hpp"
+#include "LatencyTracker.hpp"
+#include "LogArchive.hpp"
+#include "LogReplay.hpp"
+#include "LogSpill.hpp"
+#include "LogVolume.hpp"
+#include "Mailbox.hpp"
+#include "Metrics.hpp"
+#include "Sanitizer.hpp"
+#include "Trace.hpp"
+#include "SpawnBroker.hpp"
+#include "ThreadRegistry.hpp"
 
 using namespace geode::prelude;
 
@@ -12,10 +25,11 @@ Console* Console::get() {
     return &instance;
 }
 
+// Instances sharing a console all write into this directory instead of their own.
+static const std::filesystem::path SHARED_PATH = "/tmp/GeometryDash-shared/";
+
 static LONG WINAPI exceptionHandler(LPEXCEPTION_POINTERS info) {
-    auto exitPath = Config::get()->getUniquePath() / "console.exit";
-    auto res = utils::file::writeString(exitPath, "");
-    if (!res) log::error("Failed to create console exit file");
+    Console::get()->close();
 
     auto originalUEF = Console::get()->getOriginalUEF();
 
@@ -24,26 +38,133 @@ static LONG WINAPI exceptionHandler(LPEXCEPTION_POINTERS info) {
 
 void Console::setup() {
     sobriety::utils::createTempDir();
-    if (Config::get()->hasConsole()) {
-        auto watcher = FileWatcher::getForDirectory(Config::get()->getUniquePath());
-        watcher->watch("console.heartbeat", [this] {
-            setupHeartbeat();
-        });
+    if (!Config::get()->hasConsole()) return;
+
+    bool host = true;
+    if (Config::get()->isConsoleShared()) {
+        auto dirRes = utils::file::createDirectoryAll(m_consolePath / "instances");
+        if (!dirRes) {
+            discardPending();
+            return log::error("Failed to create shared console directory");
+        }
+
+        host = claimHost();
+        renewInstance();
+    }
+
+    auto watcher = FileWatcher::getForDirectory(m_consolePath);
+    watcher->watch("console.heartbeat", [this] {
+        setupHeartbeat();
+        // the heartbeat thread polls the file from here on, no need to hear about every beat
+        FileWatcher::getForDirectory(m_consolePath)->unwatch("console.heartbeat");
+    });
+    ConsoleControl::get()->setup(m_consolePath);
+
+    setupSinks(host);
+    FreeConsole();
+
+    if (!host) {
+        log::info("Attached to the shared console as instance {}", m_tag);
+        return;
+    }
+
+    setupScript();
+    m_ready = true;
+
+    if (Config::get()->isConsoleShared() || Config::get()->getConsoleOpenMode() == "always" || m_openRequested) open();
+}
+
+/*
+    Spawns the terminal, unless it's already up or setup hasn't gotten far enough yet, in which case
+    setup opens it once it's done. The backlog is written out first so the viewer starts from the top of it.
+*/
+void Console::open() {
+    m_openRequested = true;
+    if (!m_ready || m_opened.exchange(true)) return;
+
+    if (auto terminalSink = m_terminalSink.load()) terminalSink->open();
+
+    SpawnBroker::get()->spawn({
+        .args = {
+            utils::string::pathToString(m_consolePath / "openConsole.exe"),
+            utils::string::pathToString(m_consolePath),
+            std::to_string(Config::get()->getFontSize()),
+            "#" + cc3bToHexString(Config::get()->getConsoleForegroundColor()),
+            "#" + cc3bToHexString(Config::get()->getConsoleBackgroundColor()),
+            Config::get()->getTerminal(),
+            Config::get()->isConsoleShared() ? "shared" : ""
+        }
+    });
+}
 
-        setupLogFile();
-        setupScript();
-        setupEvents();
+// Replaying the backlog shouldn't hold up whoever asked, which may be the main thread or a log call.
+void Console::requestOpen() {
+    if (m_openRequested.exchange(true)) return;
+    ThreadRegistry::get()->spawn({ .name = "console open", .priority = ThreadPriority::Normal }, [this](std::stop_token) {
+        open();
+    });
+}
+
+/*
+    The first instance to claim the host lock spawns the shared console, everyone after attaches to it.
+    A lock left behind by a crashed host is taken over once there is no fresh heartbeat next to it.
+*/
+bool Console::claimHost() {
+    std::error_code ec;
+    auto lockPath = m_consolePath / "host.lock";
+
+    if (std::filesystem::create_directory(lockPath, ec)) return true;
+
+    auto heartbeatRes = utils::file::readString(m_consolePath / "console.heartbeat");
+    if (heartbeatRes) {
+        auto str = heartbeatRes.unwrap();
+        utils::string::trimIP(str);
+        if (auto millisRes = numFromString<long long>(str)) {
+            auto nowMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::system_clock::now().time_since_epoch()
+            ).count();
+            if (nowMs - millisRes.unwrap() <= Config::get()->getHeartbeatThreshold()) return false;
+        }
+    }
+
+    // another instance may have just taken the lock and not started its console yet
+    auto lockTime = std::filesystem::last_write_time(lockPath, ec);
+    if (!ec && std::filesystem::file_time_type::clock::now() - lockTime < std::chrono::seconds(10)) return false;
 
-        FreeConsole();
-        sobriety::utils::runCommand(fmt::format("{}/openConsole.exe {} {} {} {}", Config::get()->getUniquePath(), 
-            Config::get()->getUniquePath(), 
-            Config::get()->getFontSize(), 
-            "#" + cc3bToHexString(Config::get()->getConsoleForegroundColor()), 
-            "#" + cc3bToHexString(Config::get()->getConsoleBackgroundColor())
-        ));
+    std::filesystem::remove_all(lockPath, ec);
+    return std::filesystem::create_directory(lockPath, ec);
+}
+
+// The shared console keeps running as long as any instance keeps its file fresh.
+void Console::renewInstance() {
+    auto nowMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()
+    ).count();
+
+    auto res = utils::file::writeString(m_consolePath / "instances" / m_tag, std::to_string(nowMs));
+    if (!res) log::error("Failed to renew shared console instance");
+}
 
-        m_originalUEF = SetUnhandledExceptionFilter(exceptionHandler);
+void Console::close() {
+    if (m_consolePath.empty()) return;
+
+    if (Config::get()->isConsoleShared()) {
+        std::error_code ec;
+        std::filesystem::remove(m_consolePath / "instances" / m_tag, ec);
+        return;
     }
+
+    auto exitPath = m_consolePath / "console.exit";
+    auto res = utils::file::writeString(exitPath, "");
+    if (!res) log::error("Failed to create console exit file");
+}
+
+const std::filesystem::path& Console::getConsolePath() {
+    return m_consolePath;
+}
+
+const std::string& Console::getTagPrefix() {
+    return m_tagPrefix;
 }
 
 LPTOP_LEVEL_EXCEPTION_FILTER Console::getOriginalUEF() {
@@ -51,66 +172,286 @@ LPTOP_LEVEL_EXCEPTION_FILTER Console::getOriginalUEF() {
 }
 
 void Console::setConsoleColors() {
+    auto settings = Config::get()->getSettings();
+    write(fmt::format("\033]10;#{}\007", cc3bToHexString(settings->consoleForegroundColor)));
+    write(fmt::format("\033]11;#{}\007", cc3bToHexString(settings->consoleBackgroundColor)));
 
-    auto appender = Console::get()->getLogAppender();
-    if (appender) {
-        appender->append(fmt::format("\033]10;#{}\007", cc3bToHexString(Config::get()->getConsoleForegroundColor())));
-        appender->append(fmt::format("\033]11;#{}\007", cc3bToHexString(Config::get()->getConsoleBackgroundColor())));
+    write(fmt::format("\033]4;33;#{}\007", cc3bToHexString(settings->logInfoColor)));
+    write(fmt::format("\033]4;229;#{}\007", cc3bToHexString(settings->logWarnColor)));
+    write(fmt::format("\033]4;9;#{}\007", cc3bToHexString(settings->logErrorColor)));
+    write(fmt::format("\033]4;243;#{}\007", cc3bToHexString(settings->logDebugColor)));
 
-        appender->append(fmt::format("\033]4;33;#{}\007", cc3bToHexString(Config::get()->getLogInfoColor())));
-        appender->append(fmt::format("\033]4;229;#{}\007", cc3bToHexString(Config::get()->getLogWarnColor())));
-        appender->append(fmt::format("\033]4;9;#{}\007", cc3bToHexString(Config::get()->getLogErrorColor())));
-        appender->append(fmt::format("\033]4;243;#{}\007", cc3bToHexString(Config::get()->getLogDebugColor())));
-    
-        appender->append("\033[A\033[B"); // forces a refresh
-    }
+    write("\033]2;Geometry Dash\007");
+    write("\033[A\033[B"); // forces a refresh
 }
 
+/*
+    This runs synchronously at load so no early logs are missed, while the log file and terminal are
+    set up in the background. Anything logged before the log file exists is held until it does.
+*/
 void Console::setupEvents() {
+    if (!Config::get()->hasConsole()) return;
+
+    m_consolePath = Config::get()->getUniquePath();
+    if (Config::get()->isConsoleShared()) {
+        static constexpr std::array tagColors = {39, 45, 76, 118, 141, 171, 208, 214};
+
+        m_consolePath = SHARED_PATH;
+        auto unique = utils::string::pathToString(Config::get()->getUniquePath().parent_path().filename());
+        m_tag = unique.substr(unique.size() - std::min<size_t>(unique.size(), 5));
+        m_tagPrefix = fmt::format("\033[38;5;{}m[{}]\033[0m ", tagColors[std::hash<std::string>{}(m_tag) % tagColors.size()], m_tag);
+    }
+
+    m_originalUEF = SetUnhandledExceptionFilter(exceptionHandler);
+    LogReplay::get()->setRecording(Config::get()->getSettings()->recordLogs);
+
     log::LogEvent().listen([] (log::BorrowedLog const& log) {
-        if (log.m_mod) {
-            if (!log.m_mod->isLoggingEnabled()) return;
-            if (log.m_severity < log.m_mod->getLogLevel()) return;
-        }
-        if (log.m_severity < Config::get()->getConsoleLogLevel()) return;
+        HookTimer timer;
+
+        // counted before any filtering, a muted mod still costs the time it takes to log
+        LogVolume::get()->record(log.m_mod, log.m_message);
+        LogReplay::get()->capture(log.m_mod, log.m_severity, log.m_threadName, log.m_message);
 
         StringBuffer<> buffer;
-        log.formatTo(buffer, Config::get()->shouldLogMillisconds());
-
-        int color = 0;
-        switch (log.m_severity) {
-            case Severity::Debug:
-                color = 243;
-                break;
-            case Severity::Info:
-                color = 33;
-                break;
-            case Severity::Warning:
-                color = 229;
-                break;
-            case Severity::Error:
-                color = 9;
-                break;
-            default:
-                color = 7;
-                break;
+        Console::get()->process(log.m_mod, log.m_severity, [&log, &buffer] {
+            // an oversized message is cut before formatting, so the full thing is never copied into the buffer
+            std::string truncated;
+            auto message = Console::get()->capMessage(log.m_message, truncated);
+            if (message.size() == log.m_message.size()) {
+                log.formatTo(buffer, Config::get()->getSettings()->logMilliseconds);
+            }
+            else {
+                auto capped = log;
+                capped.m_message = message;
+                capped.formatTo(buffer, Config::get()->getSettings()->logMilliseconds);
+            }
+            return buffer.view();
+        });
+    }).leak();
+}
+
+// A recorded line goes through the same filters, formatting and sinks as a live one.
+void Console::replay(const Log& log) {
+    LogVolume::get()->record(log.mod, log.message);
+
+    std::string formatted;
+    process(log.mod, log.severity, [this, &log, &formatted] {
+        std::string truncated;
+        auto message = capMessage(log.message, truncated);
+        if (message.size() == log.message.size()) {
+            formatted = buildLog(log);
         }
+        else {
+            auto capped = log;
+            capped.message = std::move(truncated);
+            formatted = buildLog(capped);
+        }
+        return std::string_view(formatted);
+    });
+}
 
-        size_t colorEnd = buffer.view().find_first_of('[') - 1;
+// Only called from the format step, so lines hidden by the filters are never cut or spilled.
+std::string_view Console::capMessage(std::string_view message, std::string& truncated) {
+    auto cap = Config::get()->getSettings()->messageCap;
+    if (cap == 0 || message.size() <= cap) return message;
 
-        auto str = fmt::format("\033[38;5;{}m{}\033[0m{}\n", color, buffer.view().substr(0, colorEnd), buffer.view().substr(colorEnd));
+    truncated = LogSpill::get()->truncate(message, cap);
+    Metrics::get()->add(Metrics::get()->truncatedLines);
+    return truncated;
+}
 
-        auto appender = Console::get()->getLogAppender();
-        if (appender) appender->append(str);
-    }).leak();
+// Laid out like Geode's own log lines, the sinks expect everything before the first [ to be the time and severity.
+std::string Console::buildLog(const Log& log) {
+    std::string_view severity;
+    switch (log.severity) {
+        case Severity::Debug: severity = "DEBUG"; break;
+        case Severity::Warning: severity = "WARN "; break;
+        case Severity::Error: severity = "ERROR"; break;
+        default: severity = "INFO "; break;
+    }
+
+    auto time = Config::get()->getSettings()->logMilliseconds
+        ? fmt::format("{:%H:%M:%S}.{:03}", log.time, log.milliseconds)
+        : fmt::format("{:%H:%M:%S}", log.time);
+
+    return fmt::format("{} {} [{}] [{}]: {}{}",
+        time, severity, log.threadName, log.mod ? log.mod->getName() : log.modName,
+        std::string(std::max(log.offset, 0) * 4, ' '), log.message
+    );
 }
 
-void Console::setupLogFile() {
-    auto path = Config::get()->getUniquePath() / "console.ansi";;
-    auto res = utils::file::writeString(path, "");
-    if (!res) return log::error("Failed to create console ansi file");
+/*
+    Everything after the filters only happens for lines that will actually be written, so format is
+    only called once a line has passed them.
+*/
+template <class F>
+void Console::process(Mod* mod, Severity severity, F&& format) {
+    auto metrics = Metrics::get();
+
+    if (mod) {
+        if (!mod->isLoggingEnabled()) return metrics->add(metrics->suppressedLines);
+        if (severity < mod->getLogLevel()) return metrics->add(metrics->suppressedLines);
+    }
+    if (severity < getMinimumSeverity()) return metrics->add(metrics->suppressedLines);
+    if (!ConsoleControl::get()->allows(mod, severity)) return metrics->add(metrics->suppressedLines);
+
+    auto start = std::chrono::steady_clock::now();
+
+    std::optional<TraceSpan> formatSpan(std::in_place, "log format", "console");
 
-    m_logAppender = std::make_shared<FileAppender>(path);
+    std::string_view formatted = format();
+
+    // almost every line is clean and goes through as is, only broken ones are copied
+    std::string sanitized;
+    if (!sobriety::sanitizer::isClean(formatted)) {
+        sanitized = sobriety::sanitizer::sanitize(formatted);
+        formatted = sanitized;
+        metrics->add(metrics->sanitizedLines);
+    }
+
+    formatSpan.reset();
+
+    LogRecord record(severity, formatted, m_tagPrefix);
+    dispatch(record);
+
+    metrics->add(metrics->logLines);
+    metrics->add(metrics->logBytes, formatted.size());
+    LatencyTracker::get()->record(LatencyStage::LogWrite, start);
+}
+
+/*
+    The terminal always gets a sink, the rest are opt in. Lines logged before this point are
+    replayed into the sinks before they're published, so nothing arrives out of order.
+*/
+void Console::setupSinks(bool truncate) {
+    auto sinks = std::make_shared<std::vector<std::shared_ptr<LogSink>>>();
+    auto settings = Config::get()->getSettings();
+
+    auto path = m_consolePath / "console.ansi";
+    if (truncate) {
+        auto res = utils::file::writeString(path, "");
+        if (!res) {
+            discardPending();
+            return log::error("Failed to create console ansi file");
+        }
+    }
+
+    // a shared console is read by other instances, so it can't wait for this one to open it
+    auto terminalSink = std::make_shared<TerminalSink>(path, Config::get()->isConsoleShared());
+    sinks->push_back(terminalSink);
+
+    if (settings->consoleArchive) {
+        LogArchive::get()->setup();
+        sinks->push_back(std::make_shared<ArchiveSink>());
+    }
+
+    if (settings->logFileEnabled) {
+        auto logsDir = Mod::get()->getSaveDir() / "logs";
+        auto dirRes = utils::file::createDirectoryAll(logsDir);
+        if (dirRes) {
+            auto nowMs = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+            sinks->push_back(std::make_shared<PlainFileSink>(logsDir / fmt::format("console-{}.log", nowMs)));
+        }
+        else log::error("Failed to create logs directory");
+    }
+
+    // wine can't reach the journal, so lines are handed to logger on the linux side through the broker
+    if (settings->syslogEnabled) {
+        auto syslogPath = Config::get()->getUniquePath() / "syslog.queue";
+        auto res = utils::file::writeString(syslogPath, "");
+        if (res) {
+            sinks->push_back(std::make_shared<SyslogSink>(syslogPath));
+            SpawnBroker::get()->spawn({
+                .args = {
+                    "bash", "-c",
+                    R"(tail -n +1 -F --pid="$BROKER_PID" "$1" | logger --prio-prefix -t geometry-dash)",
+                    "_", utils::string::pathToString(syslogPath)
+                }
+            });
+        }
+        else log::error("Failed to create syslog queue file");
+    }
+
+    if (settings->loopbackPort > 0) {
+        sinks->push_back(std::make_shared<LoopbackSink>(settings->loopbackPort));
+    }
+
+    for (const auto& sink : *sinks) {
+        sink->start();
+    }
+
+    std::lock_guard lock(m_pendingMutex);
+    if (m_evictedPending > 0) {
+        terminalSink->enqueue(std::make_shared<const std::string>(fmt::format(
+            "{}\033[38;5;243m[console] {} lines from startup didn't fit in the backlog\033[0m\n", m_tagPrefix, m_evictedPending
+        )));
+    }
+    for (const auto& pending : m_pendingLogs) {
+        LogRecord record(pending.severity, pending.formatted, m_tagPrefix);
+        for (const auto& sink : *sinks) {
+            if (record.getSeverity() >= sink->getThreshold()) sink->enqueue(record.get(sink->getEncoding()));
+        }
+    }
+    m_pendingLogs.clear();
+    m_pendingBytes = 0;
+
+    m_terminalSink.store(terminalSink);
+    m_sinks.store(sinks);
+}
+
+// Nothing will ever drain the backlog once setup has given up, so it stops growing here.
+void Console::discardPending() {
+    std::lock_guard lock(m_pendingMutex);
+    m_pendingDiscarded = true;
+    m_pendingLogs.clear();
+    m_pendingBytes = 0;
+}
+
+void Console::dispatch(LogRecord& record) {
+    if (record.getSeverity() >= Severity::Warning && !m_openRequested && Config::get()->getSettings()->consoleOpenMode == "first-warning") {
+        requestOpen();
+    }
+
+    auto sinks = m_sinks.load();
+    if (!sinks) {
+        std::lock_guard lock(m_pendingMutex);
+
+        // the sinks may have been published while we waited for the lock
+        sinks = m_sinks.load();
+        if (!sinks) {
+            if (m_pendingDiscarded) return Metrics::get()->add(Metrics::get()->droppedLines);
+
+            m_pendingLogs.push_back({record.getSeverity(), std::string(record.getFormatted())});
+            m_pendingBytes += m_pendingLogs.back().formatted.size();
+            while (m_pendingBytes > MAX_PENDING_BYTES && m_pendingLogs.size() > 1) {
+                m_pendingBytes -= m_pendingLogs.front().formatted.size();
+                m_pendingLogs.pop_front();
+                m_evictedPending++;
+            }
+            return;
+        }
+    }
+
+    for (const auto& sink : *sinks) {
+        if (record.getSeverity() >= sink->getThreshold()) sink->enqueue(record.get(sink->getEncoding()));
+    }
+}
+
+Severity Console::getMinimumSeverity() {
+    auto sinks = m_sinks.load();
+    if (!sinks) return Config::get()->getSettings()->consoleLogLevel;
+
+    auto minimum = Severity::Error;
+    for (const auto& sink : *sinks) {
+        minimum = std::min(minimum, sink->getThreshold());
+    }
+    return minimum;
+}
+
+// Raw writes only go to the terminal, they're escape sequences meant for it and nothing else.
+void Console::write(const std::string& str) {
+    auto terminalSink = m_terminalSink.load();
+    if (terminalSink) terminalSink->enqueue(std::make_shared<const std::string>(str));
 }
 
 void Console::setupScript() {
@@ -121,37 +462,194 @@ UNIQUE_PATH="${1}"
 FONT_SIZE="${2:-10}"
 FG_COLOR="${3:-#ffffff}"
 BG_COLOR="${4:-#000000}"
+TERMINAL="${5:-auto}"
+SHARED="${6}"
+TITLE="Geometry Dash"
 
 CONSOLE_FILE="$UNIQUE_PATH/console.ansi"
 HEARTBEAT_FILE="$UNIQUE_PATH/console.heartbeat"
 EXIT_FILE="$UNIQUE_PATH/console.exit"
+FILTER_FILE="$UNIQUE_PATH/console.filter"
+CONTROL_FILE="$UNIQUE_PATH/console.control"
+INSTANCES_DIR="$UNIQUE_PATH/instances"
+
+# the file only ever holds this session's output, so the viewer starts from the top instead of the last few lines
+VIEWER=(tail -n +1 -F "$CONSOLE_FILE")
+
+# Shared consoles only show lines tagged with the instance in the filter file (or everything if it's empty),
+# along with color changes and the console's own messages.
+if [ -n "$SHARED" ]; then
+    TITLE="Geometry Dash (Shared)"
+    : > "$FILTER_FILE"
+
+    # mawk buffers its input unless told it's interactive, gawk just ignores the flag
+    AWK=(awk)
+    awk -W interactive "BEGIN {}" < /dev/null > /dev/null 2>&1 && AWK=(awk -W interactive)
+
+    VIEWER=(bash -c '
+        tail -n +1 -F "$1" | "${@:3}" -v FILTER_FILE="$2" "
+            NR % 32 == 1 {
+                FILTER = \"\"
+                while ((getline LINE < FILTER_FILE) > 0) FILTER = LINE
+                close(FILTER_FILE)
+            }
+            FILTER == \"\" || index(\$0, \"[\" FILTER \"]\") || index(\$0, \"\033]\") || index(\$0, \"[console]\") { print; fflush() }
+        " 2>/dev/null
+    ' _ "$CONSOLE_FILE" "$FILTER_FILE" "${AWK[@]}")
+fi
+
+# Anything typed into the console is passed back to the game as a command, while the output keeps running.
+: > "$CONTROL_FILE"
+VIEWER=(bash -c '
+    "${@:2}" &
+    printf "\033[38;5;243m[console] type help for commands\033[0m\n"
+    while IFS= read -r LINE; do
+        printf "%s\n" "$LINE" >> "$1"
+    done
+    wait
+' _ "$CONTROL_FILE" "${VIEWER[@]}")
+
+# Each backend maps the font, color and title settings onto its own flags, and returns 1 if it isn't installed.
+# Colors are also sent as escape sequences once the console is up, for terminals that can't take them as flags.
+
+launch_foot() {
+    command -v foot >/dev/null 2>&1 || return 1
+    [ -n "$WAYLAND_DISPLAY" ] || return 1
+    foot \
+      --title="$TITLE" \
+      --font="monospace:size=$FONT_SIZE" \
+      -o "colors.foreground=${FG_COLOR#\#}" \
+      -o "colors.background=${BG_COLOR#\#}" \
+      "${VIEWER[@]}" &
+}
 
-/usr/bin/xterm \
-  -fa "Monospace" \
-  -bg "$BG_COLOR" \
-  -fg "$FG_COLOR" \
-  -T "Geometry Dash" \
-  -fs "$FONT_SIZE" \
-  -xrm "XTerm*VT100.Translations: #override Ctrl Shift <Key>C: copy-selection(CLIPBOARD)" \
-  -e tail -F "$CONSOLE_FILE" &
+launch_alacritty() {
+    command -v alacritty >/dev/null 2>&1 || return 1
+    alacritty \
+      --title "$TITLE" \
+      -o "font.size=$FONT_SIZE" \
+      -o "colors.primary.foreground='$FG_COLOR'" \
+      -o "colors.primary.background='$BG_COLOR'" \
+      -e "${VIEWER[@]}" &
+}
 
-TERM_PID=$!
+launch_kitty() {
+    command -v kitty >/dev/null 2>&1 || return 1
+    kitty \
+      --title "$TITLE" \
+      -o "font_size=$FONT_SIZE" \
+      -o "foreground=$FG_COLOR" \
+      -o "background=$BG_COLOR" \
+      "${VIEWER[@]}" &
+}
 
-while [ ! -f "$EXIT_FILE" ]; do
+launch_wezterm() {
+    command -v wezterm >/dev/null 2>&1 || return 1
+    wezterm \
+      --config "font_size=$FONT_SIZE" \
+      --config "colors={foreground='$FG_COLOR',background='$BG_COLOR'}" \
+      start --always-new-process -- "${VIEWER[@]}" &
+}
+
+launch_konsole() {
+    command -v konsole >/dev/null 2>&1 || return 1
+    konsole \
+      --nofork \
+      -p "TabTitle=$TITLE" \
+      -p "Font=Monospace,$FONT_SIZE" \
+      -e "${VIEWER[@]}" &
+}
+
+launch_xterm() {
+    command -v xterm >/dev/null 2>&1 || return 1
+    xterm \
+      -fa "Monospace" \
+      -bg "$BG_COLOR" \
+      -fg "$FG_COLOR" \
+      -T "$TITLE" \
+      -fs "$FONT_SIZE" \
+      -xrm "XTerm*VT100.Translations: #override Ctrl Shift <Key>C: copy-selection(CLIPBOARD)" \
+      -e "${VIEWER[@]}" &
+}
+
+BACKENDS=(foot alacritty kitty wezterm xterm konsole)
+[ "$TERMINAL" != "auto" ] && BACKENDS=("$TERMINAL" "${BACKENDS[@]}")
+
+TERM_PID=""
+for BACKEND in "${BACKENDS[@]}"; do
+    launch_"$BACKEND" 2>/dev/null || continue
+    TERM_PID=$!
+
+    # some terminals exist but can't run here (no wayland, no GPU), so make sure it actually stayed up
+    sleep 0.2
+    kill -0 "$TERM_PID" 2>/dev/null && break
+    TERM_PID=""
+done
+
+[ -z "$TERM_PID" ] && exit 1
+
+announce() {
+    printf '\033[38;5;243m[console] %s\033[0m\n' "$1" >> "$CONSOLE_FILE"
+}
+
+# Each instance keeps its own file fresh, a shared console closes once none are left.
+declare -A KNOWN_INSTANCES
+check_instances() {
+    local NOW ALIVE=0 INSTANCE TAG
+    local -A SEEN
+    NOW=$(date +%s)
+
+    for INSTANCE in "$INSTANCES_DIR"/*; do
+        [ -f "$INSTANCE" ] || continue
+        TAG="${INSTANCE##*/}"
+
+        if (( NOW - $(stat -c %Y "$INSTANCE") > 5 )); then
+            rm -f "$INSTANCE"
+            continue
+        fi
+
+        SEEN[$TAG]=1
+        ALIVE=$((ALIVE + 1))
+        [ -z "${KNOWN_INSTANCES[$TAG]}" ] && announce "instance $TAG joined, filter with: echo $TAG > $FILTER_FILE"
+    done
+
+    for TAG in "${!KNOWN_INSTANCES[@]}"; do
+        [ -z "${SEEN[$TAG]}" ] && announce "instance $TAG left"
+    done
+
+    KNOWN_INSTANCES=()
+    for TAG in "${!SEEN[@]}"; do
+        KNOWN_INSTANCES[$TAG]=1
+    done
+
+    [ "$ALIVE" -gt 0 ]
+}
+
+TICK=0
+while true; do
     if ! kill -0 "$TERM_PID" 2>/dev/null; then
         break
     fi
 
+    if [ -n "$SHARED" ]; then
+        if (( TICK++ % 60 == 0 )); then
+            check_instances || break
+        fi
+    elif [ -f "$EXIT_FILE" ]; then
+        break
+    fi
+
     date +%s%3N > "$HEARTBEAT_FILE"
     sleep 0.016667
 done
 
 kill "$TERM_PID" 2>/dev/null
 rm -f "$EXIT_FILE"
+[ -n "$SHARED" ] && rm -rf "$UNIQUE_PATH/host.lock"
 
 )script";
 
-    auto path = Config::get()->getUniquePath() / "openConsole.exe";
+    auto path = m_consolePath / "openConsole.exe";
     auto res = utils::file::writeString(path, script);
     if (!res) return log::error("Failed to create openConsole script");
 }
@@ -160,9 +658,15 @@ void Console::setupHeartbeat() {
     if (!m_hearbeatActive) {
         setConsoleColors();
 
-        std::thread([] {
-            auto heartbeatPath = Config::get()->getUniquePath() / "console.heartbeat";
-            while (true) {
+        ThreadRegistry::get()->spawn({ .name = "console heartbeat" }, [this](std::stop_token token) {
+            auto heartbeatPath = m_consolePath / "console.heartbeat";
+            long long lastAge = -1;
+            int ticks = 0;
+            while (!token.stop_requested()) {
+                if (Config::get()->isConsoleShared() && ticks++ % 20 == 0) renewInstance();
+
+                std::optional<TraceSpan> span(std::in_place, "heartbeat check", "console");
+
                 auto strRes = utils::file::readString(heartbeatPath);
                 if (!strRes) {
                     continue;
@@ -184,19 +688,37 @@ void Console::setupHeartbeat() {
                     now.time_since_epoch()
                 ).count();
 
-                if (nowMs - millis > Config::get()->getHeartbeatThreshold()) {
-                    queueInMainThread([] {
+                auto age = nowMs - millis;
+                auto metrics = Metrics::get();
+                metrics->heartbeatAge.store(age, std::memory_order_relaxed);
+                if (lastAge >= 0) {
+                    // smoothed like the TCP RTT variance, so a single late beat doesn't dominate the figure
+                    auto jitter = metrics->heartbeatJitter.load(std::memory_order_relaxed);
+                    jitter += (std::abs(age - lastAge) - jitter) / 16.0;
+                    metrics->heartbeatJitter.store(jitter, std::memory_order_relaxed);
+                }
+                lastAge = age;
+
+                if (age > Config::get()->getHeartbeatThreshold()) {
+                    Mailbox::get()->post([] {
                         utils::game::exit(false);
                     });
                     break;
                 }
-                std::this_thread::sleep_for(std::chrono::milliseconds(50));
+                span.reset();
+                ThreadRegistry::sleepFor(token, std::chrono::milliseconds(50));
             }
-        }).detach();
+        });
         m_hearbeatActive = true;
     }
 }
 
-std::shared_ptr<FileAppender> Console::getLogAppender() {
-    return m_logAppender;
-}
\ No newline at end of file
+class $modify(CCKeyboardDispatcher) {
+    bool dispatchKeyboardMSG(enumKeyCodes key, bool isKeyDown, bool isKeyRepeat, double t) {
+        HookTimer timer;
+        if (key == KEY_F12 && isKeyDown && !isKeyRepeat && Config::get()->getSettings()->consoleOpenMode == "hotkey") {
+            Console::get()->requestOpen();
+        }
+        return CCKeyboardDispatcher::dispatchKeyboardMSG(key, isKeyDown, isKeyRepeat, t);
+    }
+};
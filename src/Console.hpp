@@ -1,11 +1,23 @@
 #pragma once
 
 #include <Geode/loader/Mod.hpp>
+#include <atomic>
+#include <deque>
+#include <filesystem>
 #include <memory>
-#include "FileAppender.hpp"
+#include <mutex>
+#include <vector>
+#include "LogSink.hpp"
+
+struct PendingLog {
+    geode::Severity severity;
+    std::string formatted;
+};
 
 struct Log {
     geode::Mod* mod;
+    // shown when the mod isn't loaded, like a recorded line from a mod this game doesn't have
+    std::string modName;
     geode::Severity severity = geode::Severity::Info;
     std::string message;
     std::string threadName;
@@ -22,15 +34,46 @@ public:
     void setup();
     void setupEvents();
     void setupScript();
-    void setupLogFile();
+    void setupSinks(bool truncate);
     void setupHeartbeat();
+    void open();
+    void requestOpen();
+    void close();
     void setConsoleColors();
+    void write(const std::string& str);
+    void dispatch(LogRecord& record);
+    geode::Severity getMinimumSeverity();
     std::string buildLog(const Log& log);
-    std::shared_ptr<FileAppender> getLogAppender();
+    void replay(const Log& log);
     LPTOP_LEVEL_EXCEPTION_FILTER getOriginalUEF();
+    const std::filesystem::path& getConsolePath();
+    const std::string& getTagPrefix();
 
 private:
+    template <class F>
+    void process(geode::Mod* mod, geode::Severity severity, F&& format);
+    std::string_view capMessage(std::string_view message, std::string& truncated);
+
+    bool claimHost();
+    void renewInstance();
+    void discardPending();
+
     bool m_hearbeatActive;
+    std::atomic<bool> m_ready = false;
+    std::atomic<bool> m_opened = false;
+    std::atomic<bool> m_openRequested = false;
     LPTOP_LEVEL_EXCEPTION_FILTER m_originalUEF;
-    std::shared_ptr<FileAppender> m_logAppender;
+    // lines logged before the sinks exist, capped like the terminal's own backlog
+    static constexpr size_t MAX_PENDING_BYTES = 4 * 1024 * 1024;
+
+    std::atomic<std::shared_ptr<std::vector<std::shared_ptr<LogSink>>>> m_sinks;
+    std::atomic<std::shared_ptr<TerminalSink>> m_terminalSink;
+    std::deque<PendingLog> m_pendingLogs;
+    size_t m_pendingBytes = 0;
+    size_t m_evictedPending = 0;
+    bool m_pendingDiscarded = false;
+    std::mutex m_pendingMutex;
+    std::filesystem::path m_consolePath;
+    std::string m_tag;
+    std::string m_tagPrefix;
 };
\ No newline at end of file
@@ -0,0 +1,267 @@
+#include <Geode/Geode.hpp>
+#include "ConsoleControl.hpp"
+#include "Config.hpp"
+#include "Console.hpp"
+#include "FileExplorer.hpp"
+#include "FileWatcher.hpp"
+#include "LatencyTracker.hpp"
+#include "LogArchive.hpp"
+#include "LogReplay.hpp"
+#include "LogVolume.hpp"
+#include "Metrics.hpp"
+#include "ThreadRegistry.hpp"
+#include "Utils.hpp"
+
+using namespace geode::prelude;
+
+ConsoleControl* ConsoleControl::get() {
+    static ConsoleControl instance;
+    return &instance;
+}
+
+void ConsoleControl::setup(const std::filesystem::path& consolePath) {
+    m_controlPath = consolePath / "console.control";
+
+    // commands typed before this instance joined a shared console weren't meant for it
+    std::error_code ec;
+    auto size = std::filesystem::file_size(m_controlPath, ec);
+    m_offset = ec ? 0 : size;
+
+    FileWatcher::getForDirectory(consolePath)->watchContents("console.control", [this](const std::string& contents) {
+        readCommands(contents);
+    });
+}
+
+bool ConsoleControl::allows(Mod* mod, Severity severity) {
+    auto state = m_state.load();
+
+    if (state->paused) {
+        m_skippedWhilePaused.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    if (state->level && severity < *state->level) return false;
+    if (!state->solo.empty() && (!mod || mod->getID() != state->solo)) return false;
+    if (!state->muted.empty() && mod && state->muted.contains(mod->getID())) return false;
+
+    return true;
+}
+
+void ConsoleControl::update(std::function<void(ControlState&)>&& change) {
+    auto state = std::make_shared<ControlState>(*m_state.load());
+    change(*state);
+    m_state.store(std::move(state));
+}
+
+// Runs on the main thread from the watcher, only whole lines are taken so a command is never read half written.
+void ConsoleControl::readCommands(std::string_view contents) {
+    // the console empties the file when it starts
+    if (contents.size() < m_offset) m_offset = 0;
+
+    while (true) {
+        auto end = contents.find('\n', m_offset);
+        if (end == std::string_view::npos) break;
+
+        auto line = contents.substr(m_offset, end - m_offset);
+        m_offset = end + 1;
+        handle(line);
+    }
+}
+
+void ConsoleControl::reply(std::string_view message) {
+    Console::get()->write(fmt::format("{}\033[38;5;243m[console] {}\033[0m\n", Console::get()->getTagPrefix(), message));
+}
+
+void ConsoleControl::replyLatency() {
+    for (size_t i = 0; i < static_cast<size_t>(LatencyStage::Count); i++) {
+        reply(fmt::format("latency {}", LatencyTracker::get()->summarize(static_cast<LatencyStage>(i))));
+    }
+}
+
+/*
+    Goes through the real pick hook one pick at a time, so every stage from the spawn to the future resolving
+    gets a sample. It's meant for stand-in pickers that answer on their own, a real one would need clicking through.
+*/
+void ConsoleControl::runPicks(size_t remaining, size_t total) {
+    if (remaining == 0) {
+        reply(fmt::format("latency after {} picks:", total));
+        return replyLatency();
+    }
+
+    log::info("Latency pick {} of {}", total - remaining + 1, total);
+    async::spawn(utils::file::pick(utils::file::PickMode::OpenFile, {}), [this, remaining, total](auto) {
+        runPicks(remaining - 1, total);
+    });
+}
+
+void ConsoleControl::handle(std::string_view line) {
+    std::vector<std::string> args;
+    for (auto& arg : utils::string::split(std::string(line), " ")) {
+        utils::string::trimIP(arg);
+        if (!arg.empty()) args.push_back(std::move(arg));
+    }
+    if (args.empty()) return;
+
+    auto command = utils::string::toLower(args[0]);
+    auto argument = args.size() > 1 ? args[1] : "";
+
+    if (command == "level") {
+        if (argument.empty() || argument == "reset") {
+            update([](ControlState& state) { state.level.reset(); });
+            return reply("level follows the in-game setting again");
+        }
+
+        auto name = utils::string::toLower(argument);
+        if (name == "warn") name = "warning";
+        if (name != "debug" && name != "info" && name != "warning" && name != "error") {
+            return reply(fmt::format("unknown level {}, use debug, info, warn or error", argument));
+        }
+
+        auto severity = sobriety::utils::fromString(name);
+        update([severity](ControlState& state) { state.level = severity; });
+
+        // lines below the in-game level are skipped before the filter here ever sees them
+        auto minimum = Config::get()->getSettings()->consoleLogLevel;
+        if (severity < minimum) {
+            return reply(fmt::format("the in-game console level is {}, level can only raise it, so still showing {} and above",
+                sobriety::utils::toString(minimum), sobriety::utils::toString(minimum)
+            ));
+        }
+        return reply(fmt::format("only showing {} and above", name));
+    }
+
+    if (command == "mute") {
+        if (argument.empty()) return reply("usage: mute <mod id>");
+        update([&argument](ControlState& state) { state.muted.insert(argument); });
+        return reply(fmt::format("muted {}", argument));
+    }
+
+    if (command == "unmute") {
+        if (argument.empty() || argument == "all") {
+            update([](ControlState& state) { state.muted.clear(); });
+            return reply("unmuted everything");
+        }
+        update([&argument](ControlState& state) { state.muted.erase(argument); });
+        return reply(fmt::format("unmuted {}", argument));
+    }
+
+    if (command == "solo") {
+        if (argument.empty() || argument == "off") {
+            update([](ControlState& state) { state.solo.clear(); });
+            return reply("showing every mod again");
+        }
+        update([&argument](ControlState& state) { state.solo = argument; });
+        return reply(fmt::format("only showing {}", argument));
+    }
+
+    if (command == "pause") {
+        m_skippedWhilePaused = 0;
+        update([](ControlState& state) { state.paused = true; });
+        return reply("paused, type resume to continue");
+    }
+
+    if (command == "resume") {
+        update([](ControlState& state) { state.paused = false; });
+        return reply(fmt::format("resumed, {} lines were skipped while paused", m_skippedWhilePaused.load()));
+    }
+
+    if (command == "stats") {
+        auto metrics = Metrics::get();
+        auto state = m_state.load();
+
+        std::string muted;
+        for (const auto& id : state->muted) {
+            muted += muted.empty() ? id : ", " + id;
+        }
+
+        reply(fmt::format(
+            "{} lines ({:.1f} KiB) written, {} suppressed, {} dropped, {} sanitized, {} truncated",
+            metrics->logLines.load(std::memory_order_relaxed),
+            metrics->logBytes.load(std::memory_order_relaxed) / 1024.0,
+            metrics->suppressedLines.load(std::memory_order_relaxed),
+            metrics->droppedLines.load(std::memory_order_relaxed),
+            metrics->sanitizedLines.load(std::memory_order_relaxed),
+            metrics->truncatedLines.load(std::memory_order_relaxed)
+        ));
+        reply(fmt::format(
+            "{} file changes seen, {} skipped as unchanged",
+            metrics->watcherEvents.load(std::memory_order_relaxed),
+            metrics->watcherSkipped.load(std::memory_order_relaxed)
+        ));
+        reply(fmt::format(
+            "{} main thread tasks, {} replaced by a newer one, {} pushed to a later frame",
+            metrics->mainThreadCallbacks.load(std::memory_order_relaxed),
+            metrics->mailboxSuperseded.load(std::memory_order_relaxed),
+            metrics->mailboxDeferred.load(std::memory_order_relaxed)
+        ));
+        return reply(fmt::format(
+            "level {}, muted {}, solo {}{}",
+            state->level ? sobriety::utils::toString(*state->level) : "from settings",
+            muted.empty() ? "none" : muted,
+            state->solo.empty() ? "off" : state->solo,
+            state->paused ? ", paused" : ""
+        ));
+    }
+
+    if (command == "top") {
+        auto count = numFromString<size_t>(argument).unwrapOr(5);
+        for (const auto& line : LogVolume::get()->report(std::max<size_t>(count, 1))) reply(line);
+        return;
+    }
+
+    if (command == "replay") {
+        if (argument == "stop") {
+            return reply(LogReplay::get()->stop() ? "stopping the replay" : "nothing is being replayed");
+        }
+
+        double speed = 1;
+        if (args.size() > 2) {
+            auto speedArg = utils::string::toLower(args[2]);
+            if (speedArg.ends_with("x")) speedArg.pop_back();
+            if (speedArg == "max") speed = 0;
+            else if (auto speedRes = numFromString<double>(speedArg); speedRes && speedRes.unwrap() > 0) speed = speedRes.unwrap();
+            else return reply(fmt::format("unknown speed {}, use a multiplier like 1x or 10x, or max", args[2]));
+        }
+        auto threads = std::clamp<size_t>(args.size() > 3 ? numFromString<size_t>(args[3]).unwrapOr(4) : 4, 1, 32);
+
+        auto replayRes = LogReplay::get()->replay(argument, speed, threads);
+        if (!replayRes) return reply(replayRes.unwrapErr());
+        return reply(fmt::format("replaying {}", replayRes.unwrap()));
+    }
+
+    if (command == "archive") {
+        // compressing what's pending and copying the archive can take a moment, so it stays off the main thread
+        ThreadRegistry::get()->spawn({ .name = "archive export" }, [this](std::stop_token) {
+            auto archiveRes = LogArchive::get()->exportArchive();
+            if (!archiveRes) return reply(archiveRes.unwrapErr());
+            reply(fmt::format("exported the console archive to {}", archiveRes.unwrap()));
+        });
+        return;
+    }
+
+    if (command == "latency") {
+        if (argument.empty()) return replyLatency();
+
+        auto picksRes = numFromString<size_t>(argument);
+        if (!picksRes || picksRes.unwrap() == 0) return reply("usage: latency [picks]");
+        if (FileExplorer::get()->isPickerActive()) return reply("the file picker is already open");
+
+        auto picks = std::min<size_t>(picksRes.unwrap(), 1000);
+        reply(fmt::format("running {} picks", picks));
+        return runPicks(picks, picks);
+    }
+
+    if (command == "help") {
+        reply("level <debug|info|warn|error|reset>  only show lines at or above a level, never below the in-game one");
+        reply("mute <mod id>, unmute <mod id|all>   hide a mod's lines");
+        reply("solo <mod id|off>                    only show one mod's lines");
+        reply("pause, resume                        stop and restart output");
+        reply("top [count]                          which mods and lines log the most");
+        reply("replay [file|latest] [1x|10x|max] [threads], replay stop");
+        reply("                                     play a recording back through the console");
+        reply("archive                              export the console archive to the save folder");
+        reply("latency [picks]                      latency per stage, after running that many picks");
+        return reply("stats                                what has been written and what is filtered");
+    }
+
+    reply(fmt::format("unknown command {}, type help for a list", args[0]));
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <Geode/loader/Log.hpp>
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+
+struct ControlState {
+    std::optional<geode::Severity> level;
+    std::unordered_set<std::string> muted;
+    std::string solo;
+    bool paused = false;
+};
+
+/*
+    Whatever is typed into the console window is appended to console.control, and read back here as commands.
+    They change the filter the log listener checks before formatting anything, so hidden lines cost next to nothing.
+    A shared console sends every command to every instance.
+*/
+class ConsoleControl {
+public:
+    static ConsoleControl* get();
+
+    void setup(const std::filesystem::path& consolePath);
+    bool allows(geode::Mod* mod, geode::Severity severity);
+
+private:
+    void readCommands(std::string_view contents);
+    void handle(std::string_view line);
+    void reply(std::string_view message);
+    void replyLatency();
+    void runPicks(size_t remaining, size_t total);
+    void update(std::function<void(ControlState&)>&& change);
+
+    std::filesystem::path m_controlPath;
+    uintmax_t m_offset = 0;
+    std::atomic<std::shared_ptr<const ControlState>> m_state = std::make_shared<const ControlState>();
+    std::atomic<uint64_t> m_skippedWhilePaused = 0;
+};
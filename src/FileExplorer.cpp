@@ -7,6 +7,11 @@
 #include "FileExplorer.hpp"
 #include "Config.hpp"
 #include "FileWatcher.hpp"
+#include "LatencyTracker.hpp"
+#include "Mailbox.hpp"
+#include "PickerFormat.hpp"
+#include "Trace.hpp"
+#include "SpawnBroker.hpp"
 #include "Geode/loader/Loader.hpp"
 #include "Utils.hpp"
 #include "WaitingPopup.hpp"
@@ -22,19 +27,20 @@ void FileExplorer::setup() {
     sobriety::utils::createTempDir();
 
     auto watcher = FileWatcher::getForDirectory(Config::get()->getUniquePath());
-    watcher->watch("selectedFile.txt", [this] {
-        notifySelectedFileChange();
+    watcher->watchContents("selectedFile.txt", [this](const std::string& contents) {
+        notifySelectedFileChange(contents);
     });
     setupScript();
-    setupHooks();
+    setupRevealScript();
 }
 
 bool file_openFolder_h(const std::filesystem::path& path) {
-    if (std::filesystem::is_directory(path)) {
-        FileExplorer::get()->openFile(sobriety::utils::wineToLinuxPath(path), PickMode::BrowseFiles, {});
-        return true;
-    }
-    return false;
+    HookTimer timer;
+    std::error_code ec;
+    if (!std::filesystem::exists(path, ec)) return false;
+
+    FileExplorer::get()->reveal(sobriety::utils::wineToLinuxPath(path));
+    return true;
 }
 
 arc::Future<Result<std::optional<std::filesystem::path>>> file_pick_h(utils::file::PickMode mode, utils::file::FilePickOptions options) {
@@ -51,6 +57,7 @@ arc::Future<Result<std::optional<std::filesystem::path>>> file_pick_h(utils::fil
     );
 
     co_await FileExplorer::get()->m_notify.notified();
+    FileExplorer::get()->notifyCompletion();
 
     auto path = FileExplorer::get()->getPath();
     if (!path) {
@@ -74,6 +81,7 @@ arc::Future<Result<std::vector<std::filesystem::path>>> file_pickMany_h(utils::f
     );
 
     co_await FileExplorer::get()->m_notify.notified();
+    FileExplorer::get()->notifyCompletion();
 
     auto paths = FileExplorer::get()->getPaths();
     if (!paths) {
@@ -254,6 +262,68 @@ launch_picker &
     if (!res) return log::error("Failed to create openFile script");
 }
 
+/*
+    Opening a folder doesn't need any of the picker detection, the file manager is asked directly over D-Bus,
+    which also lets it select a file instead of just opening the folder it's in. Anything without the
+    FileManager1 interface gets the folder through xdg-open.
+*/
+void FileExplorer::setupRevealScript() {
+    static std::string script =
+R"script(#!/bin/bash
+
+TARGET="$1"
+
+to_uri() {
+    local LC_ALL=C
+    local STR="$1" OUT="" C I
+    for (( I = 0; I < ${#STR}; I++ )); do
+        C="${STR:I:1}"
+        case "$C" in
+            [a-zA-Z0-9/._~-]) OUT+="$C" ;;
+            *) printf -v C '%%%02X' "'$C"; OUT+="$C" ;;
+        esac
+    done
+    printf 'file://%s' "$OUT"
+}
+
+URI="$(to_uri "$TARGET")"
+if [ -d "$TARGET" ]; then METHOD="ShowFolders"; else METHOD="ShowItems"; fi
+
+if command -v gdbus >/dev/null 2>&1; then
+    gdbus call --session --timeout 2 \
+        --dest org.freedesktop.FileManager1 \
+        --object-path /org/freedesktop/FileManager1 \
+        --method "org.freedesktop.FileManager1.$METHOD" "['$URI']" "" >/dev/null 2>&1 && exit 0
+elif command -v dbus-send >/dev/null 2>&1; then
+    dbus-send --session --print-reply --reply-timeout=2000 \
+        --dest=org.freedesktop.FileManager1 /org/freedesktop/FileManager1 \
+        "org.freedesktop.FileManager1.$METHOD" "array:string:$URI" "string:" >/dev/null 2>&1 && exit 0
+fi
+
+[ -d "$TARGET" ] || TARGET="$(dirname "$TARGET")"
+exec xdg-open "$TARGET"
+
+)script";
+
+    auto path = Config::get()->getUniquePath() / "reveal.exe";
+    auto res = utils::file::writeString(path, script);
+    if (!res) return log::error("Failed to create reveal script");
+}
+
+void FileExplorer::reveal(const std::string& path) {
+    HookTimer timer;
+    SpawnRequest request;
+
+    request.args.push_back(utils::string::pathToString(Config::get()->getUniquePath() / "reveal.exe"));
+    request.args.push_back(path);
+
+    auto spawnTime = std::chrono::steady_clock::now();
+    SpawnBroker::get()->spawn(std::move(request), [spawnTime, path](int status) {
+        Trace::get()->complete("reveal", "process", spawnTime, path);
+        if (status != 0) log::warn("Failed to show {} in the file manager", path);
+    });
+}
+
 void FileExplorer::setupHooks() {
     (void) Mod::get()->hook(
         reinterpret_cast<void*>(addresser::getNonVirtual(&utils::file::pick)),
@@ -273,75 +343,68 @@ void FileExplorer::setupHooks() {
 }
 
 void FileExplorer::openFile(const std::string& startPath, PickMode pickMode, const std::vector<std::string>& filters) {
-    auto path = Config::get()->getUniquePath() / "openFile.exe";
-    
-    std::string command = utils::string::pathToString(path);
+    HookTimer timer;
+    SpawnRequest request;
 
-    command += " \"";
-    command += utils::string::pathToString(Config::get()->getUniquePath());
-    command += "\"";
+    request.args.push_back(utils::string::pathToString(Config::get()->getUniquePath() / "openFile.exe"));
+    request.args.push_back(utils::string::pathToString(Config::get()->getUniquePath()));
+    request.args.push_back(startPath);
 
-    command += " \"";
-    command += startPath;
-    command += "\"";
-
-    command += " \"";
     switch (pickMode) {
         case PickMode::OpenFile: {
-            command += "Select a file";
+            request.args.push_back("Select a file");
             break;
         }
         case PickMode::SaveFile: {
-            command += "Save...";
+            request.args.push_back("Save...");
             break;
         }
         case PickMode::OpenFolder: {
-            command += "Select a folder";
+            request.args.push_back("Select a folder");
             break;
         }
         case PickMode::BrowseFiles: {
-            command += "Browse";
+            request.args.push_back("Browse");
             break;
         }
         case PickMode::OpenMultipleFiles: {
-            command += "Select files";
+            request.args.push_back("Select files");
             break;
         }
     }
-    command += "\"";
 
-    command += " \"";
     switch (pickMode) {
         case PickMode::OpenFile: {
-            command += "single";
+            request.args.push_back("single");
             break;
         }
         case PickMode::SaveFile: {
-            command += "save";
+            request.args.push_back("save");
             break;
         }
         case PickMode::OpenFolder: {
-            command += "dir";
+            request.args.push_back("dir");
             break;
         }
         case PickMode::BrowseFiles: {
-            command += "browse";
+            request.args.push_back("browse");
             break;
         }
         case PickMode::OpenMultipleFiles: {
-            command += "multi";
+            request.args.push_back("multi");
             break;
         }
     }
-    command += "\"";
 
     for (const auto& param : filters) {
-        command += " \"";
-        command += param;
-        command += "\"";
+        request.args.push_back(param);
     }
 
-    sobriety::utils::runCommand(command);
+    // picking the same file twice leaves the same contents behind, which still has to count as an answer
+    FileWatcher::getForDirectory(Config::get()->getUniquePath())->forget("selectedFile.txt");
+
+    m_openTime = std::chrono::steady_clock::now();
+    SpawnBroker::get()->spawn(std::move(request));
 }
 
 bool FileExplorer::isPickerActive() {
@@ -351,7 +414,7 @@ bool FileExplorer::isPickerActive() {
 void FileExplorer::setPickerActive(bool active) {
     m_pickerActive = active;
     if (active) {
-        queueInMainThread([this] {
+        Mailbox::get()->post([this] {
             m_waitingPopup = WaitingPopup::create();
             m_waitingPopup->show();
         });
@@ -359,58 +422,29 @@ void FileExplorer::setPickerActive(bool active) {
 }
 
 std::vector<std::string> FileExplorer::generateExtensionStrings(std::vector<utils::file::FilePickOptions::Filter> filters) {
-    std::vector<std::string> strings;
-
-    filters.push_back({"All Files", {"*.*"}});
-
-    for (const auto& filter : filters) {
-        std::string extStr = utils::string::trim(filter.description);
-        extStr += "|";
-        for (const auto& extension : filter.files) {
-            extStr += utils::string::trim(extension);
-            extStr += " ";
-        }
-        strings.push_back(utils::string::trim(extStr));
-    }
-    return strings;
+    return sobriety::picker::generateExtensionStrings(std::move(filters));
 }
 
-void FileExplorer::notifySelectedFileChange() {
-    auto path = Config::get()->getUniquePath() / "selectedFile.txt";
-
-    auto strRes = utils::file::readString(path);
-    if (!strRes) return;
-
-    std::string str = strRes.unwrap();
-    utils::string::trimIP(str);
+void FileExplorer::notifySelectedFileChange(const std::string& contents) {
+    auto str = utils::string::trim(contents);
 
     if (str.empty()) return;
 
-    if (str == "-1") {
-        m_path = std::nullopt;
-        m_paths = std::nullopt;
-    }
-    else {
-        auto parts = utils::string::split(str, "\n");
-        if (parts.empty()) {
-            m_path = std::nullopt;
-            m_paths = std::nullopt;
-        }
-        else {
-            m_path = std::filesystem::path(parts[0]);
-            std::vector<std::filesystem::path> paths;
-            for (const auto& path : parts) {
-                paths.push_back(path);
-            }
-            m_paths = paths;
-        }
-    }
+    m_paths = sobriety::picker::parseSelection(str);
+    m_path = m_paths ? std::optional(m_paths->front()) : std::nullopt;
 
+    m_notifyTime = std::chrono::steady_clock::now();
+    Trace::get()->complete("picker", "picker", m_openTime, str);
     m_notify.notifyAll();
     if (m_waitingPopup) m_waitingPopup->removeFromParent();
     m_pickerActive = false;
 }
 
+void FileExplorer::notifyCompletion() {
+    LatencyTracker::get()->record(LatencyStage::FutureCompletion, m_notifyTime);
+    LatencyTracker::get()->report();
+}
+
 /*
     These block inputs when file picker is active to mimic windows behavior. We do not want to actually
     block the main thread.
@@ -418,6 +452,7 @@ void FileExplorer::notifySelectedFileChange() {
 
 class $modify(CCKeyboardDispatcher) {
     bool dispatchKeyboardMSG(enumKeyCodes key, bool isKeyDown, bool isKeyRepeat, double t) {
+        HookTimer timer;
         if (FileExplorer::get()->isPickerActive()) {
             return false;
         }
@@ -427,6 +462,7 @@ class $modify(CCKeyboardDispatcher) {
 
 class $modify(CCMouseDispatcher) {
     bool dispatchScrollMSG(float x, float y) {
+        HookTimer timer;
         if (FileExplorer::get()->isPickerActive()) {
             return false;
         }
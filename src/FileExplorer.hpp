@@ -3,6 +3,7 @@
 #include "WaitingPopup.hpp"
 #include <Geode/Result.hpp>
 #include <Geode/utils/file.hpp>
+#include <chrono>
 #include <vector>
 
 enum class PickMode {
@@ -22,10 +23,13 @@ public:
     void setup();
     void setupHooks();
     void setupScript();
+    void setupRevealScript();
     void openFile(const std::string& startPath, PickMode pickMode, const std::vector<std::string>& filters);
+    void reveal(const std::string& path);
     bool isPickerActive();
     void setPickerActive(bool active);
-    void notifySelectedFileChange();
+    void notifySelectedFileChange(const std::string& contents);
+    void notifyCompletion();
     std::optional<std::filesystem::path> getPath();
     std::optional<std::vector<std::filesystem::path>> getPaths();
 
@@ -37,4 +41,6 @@ public:
     WaitingPopup* m_waitingPopup;
 private:
     bool m_pickerActive = false;
+    std::chrono::steady_clock::time_point m_openTime;
+    std::chrono::steady_clock::time_point m_notifyTime;
 };
@@ -1,17 +1,43 @@
+// the public watch API in include/FileWatch.hpp is exported from here
+#define GEODE_DEFINE_EVENT_EXPORTS
 #include <Geode/Geode.hpp>
 #include "FileWatcher.hpp"
+#include "LatencyTracker.hpp"
+#include "Mailbox.hpp"
+#include "Metrics.hpp"
 #include "Scheduler.hpp"
+#include "ThreadRegistry.hpp"
+#include "Trace.hpp"
+#include "Utils.hpp"
 
 using namespace geode::prelude;
 
 std::unordered_map<std::filesystem::path, std::shared_ptr<FileWatcher>> FileWatcher::s_watchers;
+std::mutex FileWatcher::s_watchersMutex;
+
+std::atomic<uint64_t> FileWatcher::s_nextSubscriptionId = 1;
+std::mutex FileWatcher::s_deliveryMutex;
+std::condition_variable_any FileWatcher::s_deliveryCondition;
+bool FileWatcher::s_deliveryPending = false;
+
+// Mods pass directories in all sorts of forms, they should still end up on the same watcher.
+std::filesystem::path FileWatcher::normalize(const std::filesystem::path& directory) {
+    std::error_code ec;
+    auto path = std::filesystem::weakly_canonical(directory, ec);
+    if (ec) path = directory.lexically_normal();
+    if (!path.has_filename() && path.has_parent_path() && path != path.root_path()) path = path.parent_path();
+    return path;
+}
 
 FileWatcher* FileWatcher::getForDirectory(const std::filesystem::path& directory) {
-    auto iter = s_watchers.find(directory);
+    auto key = normalize(directory);
+
+    std::lock_guard lock(s_watchersMutex);
+    auto iter = s_watchers.find(key);
 
     if (iter == s_watchers.end()) {
-        auto watcher = std::make_shared<FileWatcher>(directory);
-        s_watchers[directory] = watcher;
+        auto watcher = std::make_shared<FileWatcher>(key);
+        s_watchers[key] = watcher;
         return watcher.get();
     }
     else {
@@ -22,11 +48,269 @@ FileWatcher* FileWatcher::getForDirectory(const std::filesystem::path& directory
 }
 
 void FileWatcher::removeDirectory(const std::filesystem::path& directory) {
-    s_watchers.erase(directory);
+    std::lock_guard lock(s_watchersMutex);
+    s_watchers.erase(normalize(directory));
+}
+
+Result<uint64_t> FileWatcher::subscribe(sobriety::watch::WatchOptions&& options, sobriety::watch::WatchCallback&& callback) {
+    if (!callback) return Err("No callback given");
+    if (options.pattern.empty()) return Err("Pattern is empty");
+
+    std::error_code ec;
+    if (!std::filesystem::is_directory(options.directory, ec)) {
+        return Err(fmt::format("{} is not a directory", options.directory));
+    }
+
+    auto watcher = getForDirectory(options.directory);
+    if (watcher->m_handle == INVALID_HANDLE_VALUE) {
+        // it would never hear about anything, so the next subscriber gets to try again with a fresh one
+        std::lock_guard lock(s_watchersMutex);
+        auto iter = s_watchers.find(watcher->m_directory);
+        if (iter != s_watchers.end() && iter->second.get() == watcher) s_watchers.erase(iter);
+        return Err("Failed to watch directory");
+    }
+
+    static std::once_flag deliveryOnce;
+    std::call_once(deliveryOnce, [] {
+        ThreadRegistry::get()->spawn({ .name = "watch delivery" }, deliveryLoop);
+    });
+
+    auto subscription = std::make_shared<WatchSubscription>();
+    subscription->id = s_nextSubscriptionId++;
+    subscription->options = std::move(options);
+    subscription->options.directory = watcher->m_directory;
+    subscription->callback = std::move(callback);
+
+    std::lock_guard lock(watcher->m_mutex);
+    watcher->m_subscriptions.push_back(subscription);
+    return Ok(subscription->id);
+}
+
+/*
+    Once this returns the callback won't run again and isn't running now, so the caller can free whatever it captured.
+    Unsubscribing from inside the callback itself can't wait for it to finish, that delivery is the one in progress.
+*/
+Result<> FileWatcher::unsubscribe(uint64_t id) {
+    std::shared_ptr<WatchSubscription> removed;
+    {
+        std::lock_guard lock(s_watchersMutex);
+        for (const auto& [directory, watcher] : s_watchers) {
+            std::lock_guard watcherLock(watcher->m_mutex);
+            auto& subscriptions = watcher->m_subscriptions;
+            auto iter = std::find_if(subscriptions.begin(), subscriptions.end(), [id](const auto& subscription) {
+                return subscription->id == id;
+            });
+            if (iter == subscriptions.end()) continue;
+
+            // it may already be on its way out of the delivery thread
+            removed = *iter;
+            removed->active = false;
+            subscriptions.erase(iter);
+            break;
+        }
+    }
+    if (!removed) return Err(fmt::format("No subscription with id {}", id));
+
+    // waited for outside the watcher locks, the callback is free to subscribe or unsubscribe others
+    if (removed->deliveringThread.load() != std::this_thread::get_id()) {
+        std::lock_guard wait(removed->deliveryMutex);
+    }
+    return Ok();
+}
+
+void FileWatcher::deliver(const std::shared_ptr<WatchSubscription>& subscription, const std::filesystem::path& path) {
+    std::lock_guard lock(subscription->deliveryMutex);
+    if (!subscription->active) return;
+
+    subscription->deliveringThread = std::this_thread::get_id();
+    subscription->callback(path);
+    subscription->deliveringThread = std::thread::id();
+}
+
+// Called from the watcher thread, so this only records the change and leaves the rest to the delivery thread.
+void FileWatcher::queueChange(const std::string& name) {
+    auto now = std::chrono::steady_clock::now();
+    bool matched = false;
+    {
+        std::lock_guard lock(m_mutex);
+        for (const auto& subscription : m_subscriptions) {
+            if (!sobriety::utils::globMatch(subscription->options.pattern, name)) continue;
+            subscription->pendingNames.insert_or_assign(name, now + subscription->options.debounce);
+            matched = true;
+        }
+    }
+    if (!matched) return;
+
+    {
+        std::lock_guard lock(s_deliveryMutex);
+        s_deliveryPending = true;
+    }
+    s_deliveryCondition.notify_one();
+}
+
+std::chrono::steady_clock::time_point FileWatcher::collectDue(std::vector<std::pair<std::shared_ptr<WatchSubscription>, std::vector<std::string>>>& due) {
+    auto now = std::chrono::steady_clock::now();
+    auto next = std::chrono::steady_clock::time_point::max();
+
+    std::lock_guard lock(m_mutex);
+    for (const auto& subscription : m_subscriptions) {
+        std::vector<std::string> names;
+        auto& pending = subscription->pendingNames;
+        for (auto iter = pending.begin(); iter != pending.end();) {
+            if (iter->second > now) {
+                next = std::min(next, iter->second);
+                ++iter;
+                continue;
+            }
+            names.push_back(iter->first);
+            iter = pending.erase(iter);
+        }
+        if (!names.empty()) due.emplace_back(subscription, std::move(names));
+    }
+    return next;
+}
+
+/*
+    One thread delivers for every watcher. It sleeps until a change comes in or the
+    earliest debounce window closes, whichever is first.
+*/
+void FileWatcher::deliveryLoop(std::stop_token token) {
+    auto next = std::chrono::steady_clock::time_point::max();
+    std::vector<std::pair<std::shared_ptr<WatchSubscription>, std::vector<std::string>>> due;
+
+    while (!token.stop_requested()) {
+        {
+            std::unique_lock lock(s_deliveryMutex);
+            if (next == std::chrono::steady_clock::time_point::max()) {
+                s_deliveryCondition.wait(lock, token, [] { return s_deliveryPending; });
+            }
+            else {
+                s_deliveryCondition.wait_until(lock, token, next, [] { return s_deliveryPending; });
+            }
+            if (token.stop_requested()) return;
+            s_deliveryPending = false;
+        }
+
+        next = std::chrono::steady_clock::time_point::max();
+        {
+            std::lock_guard lock(s_watchersMutex);
+            for (const auto& [directory, watcher] : s_watchers) {
+                next = std::min(next, watcher->collectDue(due));
+            }
+        }
+
+        for (auto& [subscription, names] : due) {
+            for (auto& name : names) {
+                auto path = subscription->options.directory / name;
+
+                if (subscription->options.delivery == sobriety::watch::Delivery::Worker) {
+                    TraceSpan span("watch deliver", "watcher", name);
+                    deliver(subscription, path);
+                    continue;
+                }
+
+                auto key = Mailbox::keyFor(utils::string::pathToString(path)) ^ subscription->id;
+                Mailbox::get()->post(key, [subscription, path = std::move(path)] {
+                    TraceSpan span("watch deliver", "watcher", utils::string::pathToString(path.filename()));
+                    deliver(subscription, path);
+                });
+            }
+        }
+        due.clear();
+    }
 }
 
 void FileWatcher::watch(const std::string& name, std::function<void()>&& method) {
-    m_filesToWatch[name] = std::move(method);
+    std::lock_guard lock(m_mutex);
+    m_filesToWatch[name] = { .method = std::move(method) };
+}
+
+void FileWatcher::watchContents(const std::string& name, std::function<void(const std::string&)>&& method) {
+    std::lock_guard lock(m_mutex);
+    m_filesToWatch[name] = { .contentsMethod = std::move(method) };
+}
+
+void FileWatcher::unwatch(const std::string& name) {
+    std::lock_guard lock(m_mutex);
+    m_filesToWatch.erase(name);
+}
+
+// The next change to the file is delivered even if it ends up exactly how it was.
+void FileWatcher::forget(const std::string& name) {
+    std::lock_guard lock(m_mutex);
+    auto iter = m_filesToWatch.find(name);
+    if (iter != m_filesToWatch.end()) iter->second.seen = false;
+}
+
+/*
+    Writing a file usually fires several notifications (truncate, write, attributes), and most of them
+    leave it exactly how the last one did. Those are dropped here on the watcher thread instead of each
+    becoming a main thread callback that reads the file again.
+*/
+void FileWatcher::checkWatchedFile(const std::string& name) {
+    WatchedFile watched;
+    {
+        std::lock_guard lock(m_mutex);
+        auto iter = m_filesToWatch.find(name);
+        if (iter == m_filesToWatch.end()) return;
+        watched = iter->second;
+    }
+
+    auto path = m_directory / name;
+    std::error_code ec;
+    auto size = std::filesystem::file_size(path, ec);
+    if (ec) return;
+    auto writeTime = std::filesystem::last_write_time(path, ec);
+    if (ec) return;
+
+    auto metrics = Metrics::get();
+    if (watched.seen && size == watched.size && writeTime == watched.writeTime) {
+        return metrics->add(metrics->watcherSkipped);
+    }
+
+    std::string contents;
+    size_t hash = 0;
+    if (watched.contentsMethod) {
+        auto strRes = utils::file::readString(path);
+        if (!strRes) return;
+        contents = std::move(strRes).unwrap();
+        hash = std::hash<std::string_view>{}(contents);
+    }
+
+    bool unchanged = watched.contentsMethod && watched.seen && size == watched.size && hash == watched.hash;
+    {
+        std::lock_guard lock(m_mutex);
+        auto iter = m_filesToWatch.find(name);
+        if (iter == m_filesToWatch.end()) return;
+        iter->second.seen = true;
+        iter->second.size = size;
+        iter->second.writeTime = writeTime;
+        iter->second.hash = hash;
+    }
+
+    // only the write time moved, the contents are the same
+    if (unchanged) return metrics->add(metrics->watcherSkipped);
+
+    // keyed by the file, so if it changes again before the main thread gets to it only the latest is handled
+    auto key = Mailbox::keyFor(utils::string::pathToString(path));
+    auto queuedTime = std::chrono::steady_clock::now();
+    Mailbox::get()->post(key, [this, name, queuedTime, contents = std::move(contents)] {
+        LatencyTracker::get()->record(LatencyStage::MainThreadDispatch, queuedTime);
+        TraceSpan span("watcher dispatch", "watcher", name);
+
+        std::function<void()> method;
+        std::function<void(const std::string&)> contentsMethod;
+        {
+            std::lock_guard lock(m_mutex);
+            auto iter = m_filesToWatch.find(name);
+            if (iter == m_filesToWatch.end()) return;
+            method = iter->second.method;
+            contentsMethod = iter->second.contentsMethod;
+        }
+
+        if (contentsMethod) contentsMethod(contents);
+        else if (method) method();
+    });
 }
 
 FileWatcher::FileWatcher(const std::filesystem::path& directory) {
@@ -48,8 +332,14 @@ FileWatcher::FileWatcher(const std::filesystem::path& directory) {
         return;
     }
 
-    std::thread([this] {
-        while (true) {
+    auto threadName = fmt::format("watcher {}", utils::string::pathToString(m_directory.filename()));
+    ThreadRegistry::get()->spawn({ .name = std::move(threadName) }, [this](std::stop_token token) {
+        // the read below blocks until something changes, so stopping has to cancel it
+        std::stop_callback cancel(token, [this] {
+            CancelIoEx(m_handle, nullptr);
+        });
+
+        while (!token.stop_requested()) {
             if (!ReadDirectoryChangesW(
                 m_handle,
                 m_buffer,
@@ -65,29 +355,51 @@ FileWatcher::FileWatcher(const std::filesystem::path& directory) {
                 nullptr,
                 nullptr
             )) {
+                if (token.stop_requested()) return;
                 log::error("Failed to read directory changes: {}", GetLastError());
                 return;
             }
 
+            TraceSpan span("watcher read", "watcher");
+
+            // the buffer overflowed and the individual changes are lost, so check everything
+            if (m_bytesReturned == 0) {
+                std::vector<std::string> names;
+                {
+                    std::lock_guard lock(m_mutex);
+                    for (const auto& [name, watched] : m_filesToWatch) names.push_back(name);
+                }
+                for (const auto& name : names) checkWatchedFile(name);
+                continue;
+            }
+
             auto change = reinterpret_cast<FILE_NOTIFY_INFORMATION*>(m_buffer);
-            do {
+            while (true) {
                 std::wstring wname(change->FileName, change->FileNameLength / sizeof(WCHAR));
                 std::string name = utils::string::wideToUtf8(wname);
+                std::replace(name.begin(), name.end(), '\\', '/');
 
-                queueInMainThread([name, this] {
-                    for (const auto& [k, v] : m_filesToWatch) {
-                        if (name == k) {
-                            if (v) v();
-                        }
-                    }
-                });
-                
+                queueChange(name);
+
+                // how long it took from the file being written until we noticed
+                std::error_code ec;
+                auto writeTime = std::filesystem::last_write_time(m_directory / name, ec);
+                if (!ec) {
+                    auto lag = std::chrono::system_clock::now() - std::chrono::clock_cast<std::chrono::system_clock>(writeTime);
+                    if (lag.count() >= 0) LatencyTracker::get()->record(LatencyStage::WatcherEvent, std::chrono::duration_cast<std::chrono::steady_clock::duration>(lag));
+                }
+
+                Metrics::get()->add(Metrics::get()->watcherEvents);
+                checkWatchedFile(name);
+
+                // the last entry has an offset of 0, it still has to be handled before stopping
+                if (change->NextEntryOffset == 0) break;
                 change = reinterpret_cast<FILE_NOTIFY_INFORMATION*>(
                     reinterpret_cast<char*>(change) + change->NextEntryOffset
                 );
-            } while (change->NextEntryOffset != 0);
+            }
         }
-    }).detach();
+    });
 }
 
 FileWatcher::~FileWatcher() {
@@ -95,4 +407,12 @@ FileWatcher::~FileWatcher() {
         CloseHandle(m_handle);
     }
     Scheduler::get()->unschedule(m_id);
-}
\ No newline at end of file
+}
+
+geode::Result<uint64_t> sobriety::watch::subscribe(WatchOptions options, WatchCallback callback) {
+    return FileWatcher::subscribe(std::move(options), std::move(callback));
+}
+
+geode::Result<> sobriety::watch::unsubscribe(uint64_t id) {
+    return FileWatcher::unsubscribe(id);
+}
@@ -1,6 +1,42 @@
 #pragma once
 
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <map>
+#include <stop_token>
+#include <thread>
 #include <unordered_map>
+#include <vector>
+#include "../include/FileWatch.hpp"
+
+struct WatchSubscription {
+    uint64_t id;
+    sobriety::watch::WatchOptions options;
+    sobriety::watch::WatchCallback callback;
+    std::atomic<bool> active = true;
+
+    // held while the callback runs, so unsubscribing can wait for a delivery that already started
+    std::mutex deliveryMutex;
+    std::atomic<std::thread::id> deliveringThread;
+
+    // names seen since they were last delivered, each sent once its own deadline passes
+    std::map<std::string, std::chrono::steady_clock::time_point> pendingNames;
+};
+
+/*
+    What a watched file looked like the last time its handler ran. Size and write time are checked first
+    since they're free, the contents are only read and hashed when those moved.
+*/
+struct WatchedFile {
+    std::function<void()> method;
+    std::function<void(const std::string&)> contentsMethod;
+
+    bool seen = false;
+    uintmax_t size = 0;
+    std::filesystem::file_time_type writeTime;
+    size_t hash = 0;
+};
 
 class FileWatcher {
 public:
@@ -11,15 +47,37 @@ public:
     static void removeDirectory(const std::filesystem::path& directory);
 
     void watch(const std::string& name, std::function<void()>&& method);
+    void watchContents(const std::string& name, std::function<void(const std::string&)>&& method);
+    void unwatch(const std::string& name);
+    void forget(const std::string& name);
+
+    static geode::Result<uint64_t> subscribe(sobriety::watch::WatchOptions&& options, sobriety::watch::WatchCallback&& callback);
+    static geode::Result<> unsubscribe(uint64_t id);
 
 private:
+    static std::filesystem::path normalize(const std::filesystem::path& directory);
+    static void deliveryLoop(std::stop_token token);
+    static void deliver(const std::shared_ptr<WatchSubscription>& subscription, const std::filesystem::path& path);
+
+    void queueChange(const std::string& name);
+    void checkWatchedFile(const std::string& name);
+    std::chrono::steady_clock::time_point collectDue(std::vector<std::pair<std::shared_ptr<WatchSubscription>, std::vector<std::string>>>& due);
+
     std::string m_id;
     std::filesystem::path m_directory;
-    std::unordered_map<std::string, std::function<void()>> m_filesToWatch;
+    std::unordered_map<std::string, WatchedFile> m_filesToWatch;
+    std::vector<std::shared_ptr<WatchSubscription>> m_subscriptions;
+    std::mutex m_mutex;
 
     HANDLE m_handle;
-    char m_buffer[1024];
+    alignas(DWORD) char m_buffer[16 * 1024];
     DWORD m_bytesReturned;
 
     static std::unordered_map<std::filesystem::path, std::shared_ptr<FileWatcher>> s_watchers;
+    static std::mutex s_watchersMutex;
+
+    static std::atomic<uint64_t> s_nextSubscriptionId;
+    static std::mutex s_deliveryMutex;
+    static std::condition_variable_any s_deliveryCondition;
+    static bool s_deliveryPending;
 };
\ No newline at end of file
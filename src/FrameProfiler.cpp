@@ -0,0 +1,150 @@
+#include <Geode/Geode.hpp>
+#include <algorithm>
+#include <bit>
+#include "FrameProfiler.hpp"
+#include "Config.hpp"
+#include "Scheduler.hpp"
+
+using namespace geode::prelude;
+
+size_t FrameHistogram::getBucket(uint64_t micros) {
+    if (micros < LINEAR_LIMIT) return micros;
+
+    micros = std::min<uint64_t>(micros, (uint64_t{1} << (MAX_EXPONENT + 1)) - 1);
+    int exponent = std::bit_width(micros) - 1;
+    auto sub = (micros >> (exponent - SUB_BITS)) & ((1 << SUB_BITS) - 1);
+
+    return LINEAR_LIMIT + (exponent - SUB_BITS - 1) * (1 << SUB_BITS) + sub;
+}
+
+// the middle of the bucket, so the error is split both ways
+uint64_t FrameHistogram::getBucketValue(size_t bucket) {
+    if (bucket < LINEAR_LIMIT) return bucket;
+
+    auto offset = bucket - LINEAR_LIMIT;
+    int exponent = offset / (1 << SUB_BITS) + SUB_BITS + 1;
+    auto sub = offset % (1 << SUB_BITS);
+
+    uint64_t width = uint64_t{1} << (exponent - SUB_BITS);
+    return ((1 << SUB_BITS) + sub) * width + width / 2;
+}
+
+void FrameHistogram::record(uint64_t micros) {
+    m_buckets[getBucket(micros)]++;
+    m_count++;
+    m_max = std::max(m_max, micros);
+}
+
+uint64_t FrameHistogram::percentile(double p) const {
+    if (m_count == 0) return 0;
+
+    auto target = static_cast<uint64_t>(p * m_count);
+    uint64_t seen = 0;
+
+    for (size_t i = 0; i < BUCKET_COUNT; i++) {
+        seen += m_buckets[i];
+        if (seen > target) return std::min(getBucketValue(i), m_max);
+    }
+    return m_max;
+}
+
+uint64_t FrameHistogram::getMax() const {
+    return m_max;
+}
+
+uint64_t FrameHistogram::getCount() const {
+    return m_count;
+}
+
+void FrameHistogram::reset() {
+    m_buckets.fill(0);
+    m_count = 0;
+    m_max = 0;
+}
+
+FrameProfiler* FrameProfiler::get() {
+    static FrameProfiler instance;
+    return &instance;
+}
+
+void FrameProfiler::setup() {
+    Scheduler::get()->unschedule("frame-profiler");
+    m_histogram.reset();
+
+    auto interval = Config::get()->getFrameReportInterval();
+    if (interval <= 0) return;
+
+    Scheduler::get()->schedule("frame-profiler", [this] {
+        report();
+    }, std::chrono::seconds(interval));
+}
+
+void FrameProfiler::tick() {
+    auto now = std::chrono::steady_clock::now();
+
+    if (m_lastFrame.time_since_epoch().count() != 0) {
+        auto micros = std::chrono::duration_cast<std::chrono::microseconds>(now - m_lastFrame).count();
+        m_histogram.record(micros);
+        m_sliceMax = std::max<uint64_t>(m_sliceMax, micros);
+    }
+    else {
+        m_sliceStart = now;
+    }
+    m_lastFrame = now;
+
+    // each sparkline character covers an equal slice of the report interval and shows its worst frame
+    auto interval = std::chrono::seconds(std::max(Config::get()->getFrameReportInterval(), 1));
+    if (now - m_sliceStart >= interval / SPARKLINE_LENGTH) {
+        m_sparkline[m_sparklineIndex] = m_sliceMax;
+        m_sparklineIndex = (m_sparklineIndex + 1) % SPARKLINE_LENGTH;
+        m_sliceMax = 0;
+        m_sliceStart = now;
+    }
+}
+
+// Plain text, the sinks color the whole line by severity like any other, so over budget is marked with a !
+std::string FrameProfiler::formatMs(double ms, double budget) {
+    return fmt::format("{:.2f}ms{}", ms, ms > budget ? "!" : "");
+}
+
+std::string FrameProfiler::buildSparkline() {
+    static constexpr std::array<std::string_view, 8> levels = {"▁", "▂", "▃", "▄", "▅", "▆", "▇", "█"};
+
+    uint64_t highest = 1;
+    for (auto value : m_sparkline) highest = std::max(highest, value);
+
+    std::string sparkline;
+    for (size_t i = 0; i < SPARKLINE_LENGTH; i++) {
+        auto value = m_sparkline[(m_sparklineIndex + i) % SPARKLINE_LENGTH];
+        auto level = std::min<size_t>(value * levels.size() / (highest + 1), levels.size() - 1);
+        sparkline += levels[level];
+    }
+    return sparkline;
+}
+
+size_t FrameProfiler::countSlicesOver(double budget) {
+    return std::count_if(m_sparkline.begin(), m_sparkline.end(), [budget](uint64_t value) {
+        return value / 1000.0 > budget;
+    });
+}
+
+void FrameProfiler::report() {
+    if (m_histogram.getCount() == 0) return;
+
+    double budget = CCDirector::get()->getAnimationInterval() * 1000.0;
+    auto toMs = [](uint64_t micros) { return micros / 1000.0; };
+
+    auto over = countSlicesOver(budget);
+    log::info("Frames: {} p50 {} p95 {} p99 {} max {} (budget {:.2f}ms) {}{}",
+        m_histogram.getCount(),
+        formatMs(toMs(m_histogram.percentile(0.5)), budget),
+        formatMs(toMs(m_histogram.percentile(0.95)), budget),
+        formatMs(toMs(m_histogram.percentile(0.99)), budget),
+        formatMs(toMs(m_histogram.getMax()), budget),
+        budget,
+        buildSparkline(),
+        over > 0 ? fmt::format(" {} of {} over budget", over, SPARKLINE_LENGTH) : ""
+    );
+
+    m_histogram.reset();
+}
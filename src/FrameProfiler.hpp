@@ -0,0 +1,55 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+/*
+    Frame times in microseconds go into log-linear buckets, 16 per power of two, giving about 6% precision
+    from a few microseconds up to several seconds with a fixed amount of memory and no allocation per frame.
+*/
+class FrameHistogram {
+public:
+    static constexpr int SUB_BITS = 4;
+    static constexpr int LINEAR_LIMIT = 2 << SUB_BITS;
+    static constexpr int MAX_EXPONENT = 22;
+    static constexpr size_t BUCKET_COUNT = LINEAR_LIMIT + (MAX_EXPONENT - SUB_BITS) * (1 << SUB_BITS);
+
+    void record(uint64_t micros);
+    uint64_t percentile(double p) const;
+    uint64_t getMax() const;
+    uint64_t getCount() const;
+    void reset();
+
+private:
+    static size_t getBucket(uint64_t micros);
+    static uint64_t getBucketValue(size_t bucket);
+
+    std::array<uint32_t, BUCKET_COUNT> m_buckets{};
+    uint64_t m_count = 0;
+    uint64_t m_max = 0;
+};
+
+class FrameProfiler {
+public:
+    static FrameProfiler* get();
+
+    void setup();
+    void tick();
+    void report();
+
+private:
+    std::string buildSparkline();
+    size_t countSlicesOver(double budget);
+    std::string formatMs(double ms, double budget);
+
+    static constexpr size_t SPARKLINE_LENGTH = 32;
+
+    FrameHistogram m_histogram;
+    std::chrono::steady_clock::time_point m_lastFrame;
+    std::chrono::steady_clock::time_point m_sliceStart;
+    std::array<uint64_t, SPARKLINE_LENGTH> m_sparkline{};
+    size_t m_sparklineIndex = 0;
+    uint64_t m_sliceMax = 0;
+};
@@ -0,0 +1,63 @@
+#include <Geode/Geode.hpp>
+#include <algorithm>
+#include "LatencyTracker.hpp"
+
+using namespace geode::prelude;
+
+LatencyTracker* LatencyTracker::get() {
+    static LatencyTracker instance;
+    return &instance;
+}
+
+void LatencyTracker::record(LatencyStage stage, std::chrono::steady_clock::duration duration) {
+    double ms = std::chrono::duration<double, std::milli>(duration).count();
+    auto& stageSamples = m_stages[static_cast<size_t>(stage)];
+
+    // every log line lands here, so a slot is claimed with one add instead of a lock
+    auto index = stageSamples.total.fetch_add(1, std::memory_order_relaxed);
+    stageSamples.samples[index % LatencySamples::CAPACITY].store(ms, std::memory_order_relaxed);
+}
+
+void LatencyTracker::record(LatencyStage stage, std::chrono::steady_clock::time_point start) {
+    record(stage, std::chrono::steady_clock::now() - start);
+}
+
+std::string LatencyTracker::summarize(LatencyStage stage) {
+    auto& stageSamples = m_stages[static_cast<size_t>(stage)];
+    auto total = stageSamples.total.load(std::memory_order_relaxed);
+
+    // a sample being written while this copies is either the old or the new one, both are fine for a summary
+    std::vector<double> samples;
+    samples.reserve(std::min(total, LatencySamples::CAPACITY));
+    for (size_t i = 0; i < std::min(total, LatencySamples::CAPACITY); i++) {
+        samples.push_back(stageSamples.samples[i].load(std::memory_order_relaxed));
+    }
+
+    if (samples.empty()) return fmt::format("{}: no samples", getStageName(stage));
+
+    std::ranges::sort(samples);
+    auto percentile = [&samples](double p) {
+        return samples[std::min(samples.size() - 1, static_cast<size_t>(p * samples.size()))];
+    };
+
+    return fmt::format("{}: p50 {:.2f}ms, p95 {:.2f}ms, p99 {:.2f}ms, max {:.2f}ms ({} samples)",
+        getStageName(stage), percentile(0.5), percentile(0.95), percentile(0.99), samples.back(), total
+    );
+}
+
+void LatencyTracker::report() {
+    for (size_t i = 0; i < static_cast<size_t>(LatencyStage::Count); i++) {
+        log::debug("Latency {}", summarize(static_cast<LatencyStage>(i)));
+    }
+}
+
+std::string_view LatencyTracker::getStageName(LatencyStage stage) {
+    switch (stage) {
+        case LatencyStage::Spawn: return "spawn";
+        case LatencyStage::WatcherEvent: return "watcher event";
+        case LatencyStage::MainThreadDispatch: return "main thread dispatch";
+        case LatencyStage::FutureCompletion: return "future completion";
+        case LatencyStage::LogWrite: return "log write";
+        default: return "unknown";
+    }
+}
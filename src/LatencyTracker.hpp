@@ -0,0 +1,40 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <string_view>
+#include <vector>
+
+enum class LatencyStage {
+    Spawn,
+    WatcherEvent,
+    MainThreadDispatch,
+    FutureCompletion,
+    LogWrite,
+    Count
+};
+
+// Only the most recent samples of each stage are kept, so the distribution follows the current session.
+struct LatencySamples {
+    static constexpr size_t CAPACITY = 256;
+
+    std::array<std::atomic<double>, CAPACITY> samples{};
+    std::atomic<size_t> total = 0;
+};
+
+class LatencyTracker {
+public:
+    static LatencyTracker* get();
+
+    void record(LatencyStage stage, std::chrono::steady_clock::duration duration);
+    void record(LatencyStage stage, std::chrono::steady_clock::time_point start);
+    std::string summarize(LatencyStage stage);
+    void report();
+
+private:
+    static std::string_view getStageName(LatencyStage stage);
+
+    std::array<LatencySamples, static_cast<size_t>(LatencyStage::Count)> m_stages;
+};
@@ -0,0 +1,199 @@
+#include <Geode/Geode.hpp>
+#include "LogArchive.hpp"
+#include "Compressor.hpp"
+#include "Config.hpp"
+#include "ThreadRegistry.hpp"
+
+using namespace geode::prelude;
+
+static constexpr std::string_view ARCHIVE_MAGIC = "SBLA";
+static constexpr std::string_view INDEX_MAGIC = "SBLI";
+static constexpr char ARCHIVE_VERSION = 1;
+static constexpr size_t BLOCK_SIZE = 64 * 1024;
+
+LogArchive* LogArchive::get() {
+    static LogArchive instance;
+    return &instance;
+}
+
+template <class T>
+static void appendInt(std::string& out, T value) {
+    for (size_t i = 0; i < sizeof(T); i++) {
+        out += static_cast<char>((value >> (i * 8)) & 0xFF);
+    }
+}
+
+template <class T>
+static T readInt(std::string_view data, size_t pos) {
+    T value = 0;
+    for (size_t i = 0; i < sizeof(T); i++) {
+        value |= static_cast<T>(static_cast<uint8_t>(data[pos + i])) << (i * 8);
+    }
+    return value;
+}
+
+/*
+    Compression happens on its own thread, the log listener only ever appends to the pending buffer.
+    A block is written once it's full, or after a second so a crash loses as little as possible.
+*/
+void LogArchive::setup() {
+    auto path = Config::get()->getUniquePath() / "console.sbla";
+    m_file.open(path, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!m_file.is_open()) return log::error("Failed to create console archive");
+
+    std::string header{ARCHIVE_MAGIC};
+    header += ARCHIVE_VERSION;
+    m_file << header;
+    m_fileOffset = header.size();
+
+    m_active = true;
+
+    ThreadRegistry::get()->spawn({ .name = "console archive" }, [this](std::stop_token token) {
+        while (!token.stop_requested()) {
+            {
+                std::unique_lock lock(m_mutex);
+                m_condition.wait_for(lock, token, std::chrono::seconds(1), [this] {
+                    return m_pending.size() >= BLOCK_SIZE;
+                });
+                if (m_pending.empty()) continue;
+            }
+
+            std::lock_guard fileLock(m_fileMutex);
+            writePending();
+        }
+    });
+}
+
+void LogArchive::push(std::string_view str) {
+    if (!m_active) return;
+
+    bool full;
+    {
+        std::lock_guard lock(m_mutex);
+        m_pending.append(str);
+        full = m_pending.size() >= BLOCK_SIZE;
+    }
+    if (full) m_condition.notify_one();
+}
+
+/*
+    The caller has to hold m_fileMutex from here until the blocks are written, otherwise an export could
+    take the next pending text and write its block before this one, and the archive would be out of order.
+*/
+void LogArchive::writePending() {
+    std::string raw;
+    {
+        std::lock_guard lock(m_mutex);
+        raw = std::move(m_pending);
+        m_pending.clear();
+    }
+
+    for (size_t i = 0; i < raw.size(); i += BLOCK_SIZE) {
+        writeBlock(std::string_view(raw).substr(i, BLOCK_SIZE));
+    }
+}
+
+void LogArchive::writeBlock(std::string_view raw) {
+    auto compressed = sobriety::compressor::compress(raw);
+
+    std::string block;
+    appendInt<uint32_t>(block, raw.size());
+    appendInt<uint32_t>(block, compressed.size());
+    block += compressed;
+
+    m_file << block;
+    m_file.flush();
+
+    m_blocks.push_back({m_fileOffset, m_rawOffset});
+    m_fileOffset += block.size();
+    m_rawOffset += raw.size();
+}
+
+Result<std::filesystem::path> LogArchive::exportArchive() {
+    if (!m_active) return Err("Console archiving is not enabled");
+
+    // the file and index have to match, so the worker can't write blocks from here until the copy is done
+    std::lock_guard lock(m_fileMutex);
+    writePending();
+
+    auto archivesDir = Mod::get()->getSaveDir() / "archives";
+    GEODE_UNWRAP(utils::file::createDirectoryAll(archivesDir));
+
+    auto nowMs = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+    auto exportPath = archivesDir / fmt::format("console-{}.sbla", nowMs);
+
+    GEODE_UNWRAP_INTO(auto data, utils::file::readString(Config::get()->getUniquePath() / "console.sbla"));
+
+    for (const auto& block : m_blocks) {
+        appendInt<uint64_t>(data, block.fileOffset);
+        appendInt<uint64_t>(data, block.rawOffset);
+    }
+    appendInt<uint32_t>(data, m_blocks.size());
+    data += INDEX_MAGIC;
+
+    GEODE_UNWRAP(utils::file::writeString(exportPath, data));
+
+    return Ok(exportPath);
+}
+
+Result<std::string> LogArchive::decode(const std::filesystem::path& path) {
+    GEODE_UNWRAP_INTO(auto data, utils::file::readString(path));
+
+    if (data.size() < ARCHIVE_MAGIC.size() + 1 || !data.starts_with(ARCHIVE_MAGIC)) return Err("Not a console archive");
+    if (data[ARCHIVE_MAGIC.size()] != ARCHIVE_VERSION) return Err("Unsupported console archive version");
+
+    // exported archives end with the block index, which isn't needed to restore everything
+    size_t end = data.size();
+    if (data.ends_with(INDEX_MAGIC) && end >= ARCHIVE_MAGIC.size() + 1 + INDEX_MAGIC.size() + 4) {
+        auto count = readInt<uint32_t>(data, end - INDEX_MAGIC.size() - 4);
+        size_t indexSize = static_cast<size_t>(count) * 16 + 4 + INDEX_MAGIC.size();
+        if (indexSize <= end) end -= indexSize;
+    }
+
+    std::string out;
+    size_t pos = ARCHIVE_MAGIC.size() + 1;
+
+    while (pos + 8 <= end) {
+        auto rawSize = readInt<uint32_t>(data, pos);
+        auto compressedSize = readInt<uint32_t>(data, pos + 4);
+        pos += 8;
+
+        // a block cut off by a crash is the end of what can be recovered
+        if (pos + compressedSize > end) break;
+
+        auto block = sobriety::compressor::decompress(std::string_view(data).substr(pos, compressedSize), rawSize);
+        if (!block) return Err("Corrupt block at offset {}", pos - 8);
+
+        out += *block;
+        pos += compressedSize;
+    }
+
+    return Ok(std::move(out));
+}
+
+/*
+    Archives dropped into the restore folder are decoded back to ANSI text next to themselves,
+    so a report can be read with any terminal using `cat` or `less -R`.
+*/
+void LogArchive::restoreArchives() {
+    std::error_code ec;
+    auto restoreDir = Mod::get()->getSaveDir() / "archives" / "restore";
+
+    for (const auto& entry : std::filesystem::directory_iterator(restoreDir, ec)) {
+        if (entry.path().extension() != ".sbla") continue;
+
+        auto outPath = entry.path();
+        outPath.replace_extension(".ansi");
+        if (std::filesystem::exists(outPath, ec)) continue;
+
+        auto res = decode(entry.path());
+        if (!res) {
+            log::error("Failed to restore archive {}: {}", entry.path().filename(), res.unwrapErr());
+            continue;
+        }
+
+        auto writeRes = utils::file::writeString(outPath, res.unwrap());
+        if (!writeRes) log::error("Failed to write restored archive {}", outPath.filename());
+        else log::info("Restored archive to {}", outPath);
+    }
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <Geode/Result.hpp>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+struct ArchiveBlock {
+    uint64_t fileOffset;
+    uint64_t rawOffset;
+};
+
+/*
+    Console output compressed in independent blocks, so any part of a long session can be restored
+    without decompressing everything before it. Layout:
+
+    "SBLA" + version byte
+    blocks: u32 raw size, u32 compressed size, compressed data
+    footer: per block u64 file offset, u64 raw offset, then u32 block count, "SBLI"
+
+    The footer is only written to exported copies. A live archive is decoded by walking the blocks.
+*/
+class LogArchive {
+public:
+    static LogArchive* get();
+
+    void setup();
+    void push(std::string_view str);
+    geode::Result<std::filesystem::path> exportArchive();
+
+    static geode::Result<std::string> decode(const std::filesystem::path& path);
+    static void restoreArchives();
+
+private:
+    void writePending();
+    void writeBlock(std::string_view raw);
+
+    // set once setup has the file ready, which may still be running on the deferred startup thread
+    std::atomic<bool> m_active = false;
+    std::string m_pending;
+    std::ofstream m_file;
+    uint64_t m_fileOffset = 0;
+    uint64_t m_rawOffset = 0;
+    std::vector<ArchiveBlock> m_blocks;
+    std::mutex m_mutex;
+    std::mutex m_fileMutex;
+    std::condition_variable_any m_condition;
+};
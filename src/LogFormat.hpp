@@ -0,0 +1,49 @@
+#pragma once
+
+#include <Geode/loader/Log.hpp>
+#include <string>
+#include <string_view>
+
+/*
+    How a formatted log line is turned into what each sink writes, kept apart from the sinks themselves so
+    the benchmarks can build it without the console and socket code around them.
+*/
+namespace sobriety::logformat {
+
+    static int getSeverityColor(geode::Severity severity) {
+        switch (severity) {
+            case geode::Severity::Debug: return 243;
+            case geode::Severity::Info: return 33;
+            case geode::Severity::Warning: return 229;
+            case geode::Severity::Error: return 9;
+            default: return 7;
+        }
+    }
+
+    static int getSyslogPriority(geode::Severity severity) {
+        switch (severity) {
+            case geode::Severity::Debug: return 7;
+            case geode::Severity::Info: return 6;
+            case geode::Severity::Warning: return 4;
+            case geode::Severity::Error: return 3;
+            default: return 5;
+        }
+    }
+
+    // Everything before the first [ is the time and severity, which is what gets colored.
+    static std::string toAnsi(geode::Severity severity, std::string_view formatted, std::string_view tagPrefix) {
+        size_t colorEnd = formatted.find_first_of('[') - 1;
+        return fmt::format("{}\033[38;5;{}m{}\033[0m{}\n",
+            tagPrefix, getSeverityColor(severity), formatted.substr(0, colorEnd), formatted.substr(colorEnd)
+        );
+    }
+
+    static std::string toPlain(std::string_view formatted) {
+        return fmt::format("{}\n", formatted);
+    }
+
+    // read by logger --prio-prefix
+    static std::string toSyslog(geode::Severity severity, std::string_view formatted) {
+        return fmt::format("<{}>{}\n", getSyslogPriority(severity), formatted);
+    }
+}
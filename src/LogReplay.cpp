@@ -0,0 +1,286 @@
+#include <Geode/Geode.hpp>
+#include <fstream>
+#include <unordered_set>
+#include "LogReplay.hpp"
+#include "Console.hpp"
+#include "Metrics.hpp"
+#include "ThreadRegistry.hpp"
+#include "Trace.hpp"
+#include "Utils.hpp"
+
+using namespace geode::prelude;
+
+LogReplay* LogReplay::get() {
+    static LogReplay instance;
+    return &instance;
+}
+
+std::filesystem::path LogReplay::getReplayDirectory() {
+    return Mod::get()->getSaveDir() / "replays";
+}
+
+void LogReplay::escapeTo(std::string& out, std::string_view str) {
+    for (auto c : str) {
+        switch (c) {
+            case '\\': out += "\\\\"; break;
+            case '\t': out += "\\t"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            default: out += c; break;
+        }
+    }
+}
+
+std::string LogReplay::unescape(std::string_view str) {
+    std::string out;
+    out.reserve(str.size());
+    for (size_t i = 0; i < str.size(); i++) {
+        if (str[i] != '\\' || i + 1 == str.size()) {
+            out += str[i];
+            continue;
+        }
+        switch (str[++i]) {
+            case 't': out += '\t'; break;
+            case 'n': out += '\n'; break;
+            case 'r': out += '\r'; break;
+            default: out += str[i]; break;
+        }
+    }
+    return out;
+}
+
+std::optional<ReplayEvent> LogReplay::parse(std::string_view line) {
+    if (line.empty() || line[0] == '#') return std::nullopt;
+
+    std::array<std::string_view, 5> fields;
+    for (size_t i = 0; i < fields.size(); i++) {
+        auto end = i + 1 < fields.size() ? line.find('\t') : line.size();
+        if (end == std::string_view::npos) return std::nullopt;
+        fields[i] = line.substr(0, end);
+        line.remove_prefix(std::min(end + 1, line.size()));
+    }
+
+    auto offsetRes = numFromString<uint64_t>(fields[0]);
+    if (!offsetRes) return std::nullopt;
+
+    return ReplayEvent{
+        offsetRes.unwrap(),
+        sobriety::utils::fromString(fields[1]),
+        unescape(fields[2]),
+        unescape(fields[3]),
+        unescape(fields[4])
+    };
+}
+
+void LogReplay::setRecording(bool recording) {
+    std::filesystem::path started;
+    {
+        std::lock_guard lock(m_mutex);
+        if (recording && m_recordPath.empty()) {
+            auto dirRes = utils::file::createDirectoryAll(getReplayDirectory());
+            if (!dirRes) return log::error("Failed to create replay directory: {}", dirRes.unwrapErr());
+
+            auto nowMs = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+            m_recordPath = getReplayDirectory() / fmt::format("session-{}.replay", nowMs);
+            m_recordStart = std::chrono::steady_clock::now();
+            m_queue = "# sobriety log replay 1\n";
+            startWriter();
+            started = m_recordPath;
+        }
+        m_recording.store(recording && !m_recordPath.empty(), std::memory_order_release);
+    }
+
+    // logged outside the lock, the listener captures this line and would take it again
+    if (!started.empty()) log::info("Recording log events to {}", started);
+}
+
+// Called from the log listener on every thread, the line is built before the lock is taken.
+void LogReplay::capture(Mod* mod, Severity severity, std::string_view threadName, std::string_view message) {
+    if (!m_recording.load(std::memory_order_acquire)) return;
+
+    auto offset = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - m_recordStart).count();
+
+    std::string line = fmt::format("{}\t{}\t", offset, sobriety::utils::toString(severity));
+    line.reserve(line.size() + message.size() + 64);
+    if (mod) escapeTo(line, mod->getID());
+    line += '\t';
+    escapeTo(line, threadName);
+    line += '\t';
+    escapeTo(line, message);
+    line += '\n';
+
+    std::lock_guard lock(m_mutex);
+    if (m_queue.size() + line.size() > MAX_QUEUED_BYTES) return Metrics::get()->add(Metrics::get()->droppedLines);
+    m_queue += line;
+    m_condition.notify_one();
+}
+
+void LogReplay::startWriter() {
+    ThreadRegistry::get()->spawn({ .name = "log recorder", .priority = ThreadPriority::Low }, [this, path = m_recordPath](std::stop_token token) {
+        std::ofstream stream(path, std::ios::out | std::ios::binary | std::ios::app);
+        if (!stream.is_open()) {
+            // cleared so turning recording on again starts a new file and a new writer
+            {
+                std::lock_guard lock(m_mutex);
+                m_recording = false;
+                m_recordPath.clear();
+                m_queue.clear();
+            }
+            return log::error("Failed to create replay file {}", path);
+        }
+
+        while (true) {
+            std::string batch;
+            {
+                std::unique_lock lock(m_mutex);
+                m_condition.wait(lock, token, [this] { return !m_queue.empty(); });
+                if (m_queue.empty()) return;
+                batch.swap(m_queue);
+            }
+
+            TraceSpan span("replay record", "console");
+            stream.write(batch.data(), batch.size());
+            stream.flush();
+        }
+    });
+}
+
+/*
+    A name is looked up in the save folder's replays folder, and "latest" (or nothing) picks the newest file
+    there. A speed of 0 replays as fast as the producers can go.
+*/
+Result<std::filesystem::path> LogReplay::replay(std::string_view name, double speed, size_t threads) {
+    std::filesystem::path path;
+    if (name.empty() || name == "latest") {
+        std::error_code ec;
+        std::filesystem::file_time_type newest;
+        for (const auto& entry : std::filesystem::directory_iterator(getReplayDirectory(), ec)) {
+            if (entry.path().extension() != ".replay") continue;
+            auto writeTime = entry.last_write_time(ec);
+            if (!ec && (path.empty() || writeTime > newest)) {
+                path = entry.path();
+                newest = writeTime;
+            }
+        }
+        if (path.empty()) return Err("no recordings in {}", getReplayDirectory());
+    }
+    else {
+        path = std::filesystem::path(name);
+        if (path.is_relative()) path = getReplayDirectory() / path;
+        if (!path.has_extension()) path += ".replay";
+        if (!std::filesystem::exists(path)) return Err("{} doesn't exist", path);
+    }
+
+    if (m_replaying.exchange(true)) return Err("a replay is already running, type replay stop to end it");
+    m_stopReplay = false;
+
+    ThreadRegistry::get()->spawn({ .name = "log replay" }, [this, path, speed, threads](std::stop_token token) {
+        std::optional<TraceSpan> span(std::in_place, "replay load", "console", utils::string::pathToString(path.filename()));
+
+        auto strRes = utils::file::readString(path);
+        if (!strRes) {
+            m_replaying = false;
+            return log::error("Failed to read replay file {}: {}", path, strRes.unwrapErr());
+        }
+
+        auto str = std::move(strRes).unwrap();
+        std::vector<ReplayEvent> events;
+        std::string_view contents = str;
+        while (!contents.empty()) {
+            auto end = std::min(contents.find('\n'), contents.size());
+            if (auto event = parse(contents.substr(0, end))) events.push_back(std::move(*event));
+            contents.remove_prefix(std::min(end + 1, contents.size()));
+        }
+        span.emplace("replay", "console", utils::string::pathToString(path.filename()));
+
+        run(token, std::move(events), speed, threads);
+        m_replaying = false;
+    });
+    return Ok(path);
+}
+
+bool LogReplay::stop() {
+    if (!m_replaying) return false;
+    m_stopReplay = true;
+    return true;
+}
+
+/*
+    When the recording has at least as many threads as there are producers, each thread's lines go to one
+    producer and keep their order. Otherwise, like a session where nearly everything is on the main thread,
+    lines are dealt out in turn so every producer has work, and only their timestamps keep them in order.
+*/
+void LogReplay::run(std::stop_token token, std::vector<ReplayEvent> events, double speed, size_t threads) {
+    struct Run {
+        std::vector<std::vector<ReplayEvent>> buckets;
+        std::atomic<size_t> replayed = 0;
+        std::atomic<size_t> finished = 0;
+        std::chrono::steady_clock::time_point start;
+    };
+    // shared with the producers, the game can exit while they're still running
+    auto replayRun = std::make_shared<Run>();
+
+    std::unordered_set<std::string_view> threadNames;
+    for (const auto& event : events) threadNames.insert(event.threadName);
+    bool byThread = threadNames.size() >= threads;
+
+    auto total = events.size();
+    replayRun->buckets.resize(threads);
+    for (size_t i = 0; i < total; i++) {
+        auto bucket = byThread ? std::hash<std::string>{}(events[i].threadName) % threads : i % threads;
+        replayRun->buckets[bucket].push_back(std::move(events[i]));
+    }
+    events.clear();
+
+    log::info("Replaying {} events at {} on {} threads", total, speed > 0 ? fmt::format("{}x", speed) : "full speed", threads);
+
+    auto metrics = Metrics::get();
+    auto droppedBefore = metrics->droppedLines.load(std::memory_order_relaxed);
+    replayRun->start = std::chrono::steady_clock::now();
+
+    for (size_t i = 0; i < threads; i++) {
+        ThreadRegistry::get()->spawn({ .name = fmt::format("log replay {}", i) }, [this, replayRun, i, speed](std::stop_token token) {
+            std::unordered_map<std::string, Mod*> mods;
+
+            for (auto& event : replayRun->buckets[i]) {
+                if (token.stop_requested() || m_stopReplay) break;
+
+                if (speed > 0) {
+                    auto due = replayRun->start + std::chrono::microseconds(static_cast<uint64_t>(event.offset / speed));
+                    auto wait = std::chrono::duration_cast<std::chrono::milliseconds>(due - std::chrono::steady_clock::now());
+                    if (wait.count() > 0 && ThreadRegistry::sleepFor(token, wait)) break;
+                }
+
+                auto [iter, inserted] = mods.try_emplace(event.modID, nullptr);
+                if (inserted && !event.modID.empty()) iter->second = Loader::get()->getLoadedMod(event.modID);
+
+                auto now = std::chrono::system_clock::now();
+                auto millis = std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()).count() % 1000;
+                Console::get()->replay({
+                    .mod = iter->second,
+                    .modName = event.modID.empty() ? "unknown" : event.modID,
+                    .severity = event.severity,
+                    .message = std::move(event.message),
+                    .threadName = std::move(event.threadName),
+                    .time = sobriety::utils::convertTime(now),
+                    .milliseconds = millis,
+                    .newLine = true,
+                    .offset = 0
+                });
+                replayRun->replayed.fetch_add(1, std::memory_order_relaxed);
+            }
+            replayRun->finished.fetch_add(1, std::memory_order_release);
+        });
+    }
+
+    while (replayRun->finished.load(std::memory_order_acquire) < threads) {
+        if (ThreadRegistry::sleepFor(token, std::chrono::milliseconds(10))) return;
+    }
+
+    auto replayed = replayRun->replayed.load();
+    auto seconds = std::max(std::chrono::duration<double>(std::chrono::steady_clock::now() - replayRun->start).count(), 0.001);
+    log::info("Replayed {} of {} events in {:.2f}s, {:.0f} lines/s, {} lines dropped by the sinks",
+        replayed, total, seconds, replayed / seconds,
+        metrics->droppedLines.load(std::memory_order_relaxed) - droppedBefore
+    );
+}
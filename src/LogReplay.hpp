@@ -0,0 +1,64 @@
+#pragma once
+
+#include <Geode/loader/Mod.hpp>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <optional>
+#include <stop_token>
+#include <string>
+#include <string_view>
+#include <vector>
+
+struct ReplayEvent {
+    // microseconds since recording started
+    uint64_t offset;
+    geode::Severity severity;
+    std::string modID;
+    std::string threadName;
+    std::string message;
+};
+
+/*
+    Records every log event of a session, before any filtering, to a replay file in the save folder, and plays
+    one back into the console pipeline at its original pace, some multiple of it, or as fast as possible.
+    Events are split across the producer threads by the thread that logged them, so each thread's lines
+    stay in order while several threads log at once like they did in the game.
+
+    A replay file is one event per line, tab separated: offset, severity, mod id, thread name and message,
+    with backslashes, tabs and newlines escaped.
+*/
+class LogReplay {
+public:
+    static LogReplay* get();
+
+    void setRecording(bool recording);
+    void capture(geode::Mod* mod, geode::Severity severity, std::string_view threadName, std::string_view message);
+
+    geode::Result<std::filesystem::path> replay(std::string_view name, double speed, size_t threads);
+    bool stop();
+
+private:
+    static constexpr size_t MAX_QUEUED_BYTES = 16 * 1024 * 1024;
+
+    static std::filesystem::path getReplayDirectory();
+    static void escapeTo(std::string& out, std::string_view str);
+    static std::string unescape(std::string_view str);
+    static std::optional<ReplayEvent> parse(std::string_view line);
+
+    void startWriter();
+    void run(std::stop_token token, std::vector<ReplayEvent> events, double speed, size_t threads);
+
+    std::atomic<bool> m_recording = false;
+    std::chrono::steady_clock::time_point m_recordStart;
+    std::filesystem::path m_recordPath;
+    std::string m_queue;
+    std::mutex m_mutex;
+    std::condition_variable_any m_condition;
+
+    std::atomic<bool> m_replaying = false;
+    std::atomic<bool> m_stopReplay = false;
+};
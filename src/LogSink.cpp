@@ -0,0 +1,223 @@
+#include <Geode/Geode.hpp>
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#include "LogSink.hpp"
+#include "Config.hpp"
+#include "LogArchive.hpp"
+#include "LogFormat.hpp"
+#include "Metrics.hpp"
+#include "ThreadRegistry.hpp"
+#include "Trace.hpp"
+
+using namespace geode::prelude;
+
+LogRecord::LogRecord(Severity severity, std::string_view formatted, std::string_view tagPrefix)
+    : m_severity(severity), m_formatted(formatted), m_tagPrefix(tagPrefix) {}
+
+Severity LogRecord::getSeverity() const {
+    return m_severity;
+}
+
+std::string_view LogRecord::getFormatted() const {
+    return m_formatted;
+}
+
+const SinkData& LogRecord::get(SinkEncoding encoding) {
+    auto& data = m_encoded[static_cast<size_t>(encoding)];
+    if (data) return data;
+
+    TraceSpan span("log encode", "console");
+
+    switch (encoding) {
+        case SinkEncoding::Ansi: {
+            data = std::make_shared<const std::string>(sobriety::logformat::toAnsi(m_severity, m_formatted, m_tagPrefix));
+            break;
+        }
+        case SinkEncoding::Plain: {
+            data = std::make_shared<const std::string>(sobriety::logformat::toPlain(m_formatted));
+            break;
+        }
+        case SinkEncoding::Syslog: {
+            data = std::make_shared<const std::string>(sobriety::logformat::toSyslog(m_severity, m_formatted));
+            break;
+        }
+        default: break;
+    }
+    return data;
+}
+
+LogSink::LogSink(std::string name, SinkEncoding encoding, SinkOverflow overflow)
+    : m_name(std::move(name)), m_encoding(encoding), m_overflow(overflow) {}
+
+SinkEncoding LogSink::getEncoding() const {
+    return m_encoding;
+}
+
+const std::string& LogSink::getName() const {
+    return m_name;
+}
+
+void LogSink::start() {
+    ThreadRegistry::get()->spawn({ .name = fmt::format("log sink {}", m_name) }, [this](std::stop_token token) {
+        std::vector<SinkData> batch;
+        while (true) {
+            {
+                std::unique_lock lock(m_mutex);
+                m_condition.wait(lock, token, [this] { return !m_queue.empty(); });
+
+                // whatever is still queued when stopping gets written out first
+                if (m_queue.empty()) {
+                    m_stopped = true;
+                    m_drained.notify_all();
+                    return;
+                }
+
+                batch.assign(std::make_move_iterator(m_queue.begin()), std::make_move_iterator(m_queue.end()));
+                m_queue.clear();
+                m_queuedBytes = 0;
+            }
+            m_drained.notify_all();
+
+            TraceSpan span("log append", "console", m_name);
+            consume(batch);
+            batch.clear();
+        }
+    });
+}
+
+void LogSink::enqueue(SinkData data) {
+    {
+        std::unique_lock lock(m_mutex);
+        if (m_overflow == SinkOverflow::Block) {
+            // a line bigger than the whole budget still goes through, once the queue is empty
+            m_drained.wait(lock, [&] {
+                return m_stopped || m_queue.empty() || m_queuedBytes + data->size() <= MAX_QUEUED_BYTES;
+            });
+            if (m_stopped) return Metrics::get()->add(Metrics::get()->droppedLines);
+        }
+        else if (m_queue.size() >= MAX_QUEUED) {
+            return Metrics::get()->add(Metrics::get()->droppedLines);
+        }
+        m_queuedBytes += data->size();
+        m_queue.push_back(std::move(data));
+    }
+    m_condition.notify_one();
+}
+
+FileSink::FileSink(std::string name, SinkEncoding encoding, const std::filesystem::path& path, SinkOverflow overflow)
+    : LogSink(std::move(name), encoding, overflow), m_appender(path) {}
+
+// Everything that piled up is written with a single append and flush.
+void FileSink::consume(const std::vector<SinkData>& batch) {
+    if (batch.size() == 1) return m_appender.append(*batch[0]);
+
+    size_t size = 0;
+    for (const auto& data : batch) size += data->size();
+
+    std::string combined;
+    combined.reserve(size);
+    for (const auto& data : batch) combined += *data;
+
+    m_appender.append(combined);
+}
+
+TerminalSink::TerminalSink(const std::filesystem::path& path, bool open)
+    : FileSink("terminal", SinkEncoding::Ansi, path, SinkOverflow::Block), m_open(open) {}
+
+Severity TerminalSink::getThreshold() {
+    return Config::get()->getSettings()->consoleLogLevel;
+}
+
+void TerminalSink::open() {
+    std::lock_guard lock(m_backlogMutex);
+    if (m_open) return;
+    m_open = true;
+
+    TraceSpan span("backlog replay", "console");
+
+    std::string combined;
+    combined.reserve(m_backlogBytes + 128);
+    if (m_evictedLines > 0) {
+        combined += fmt::format("\033[38;5;243m[console] {} earlier lines didn't fit in the backlog\033[0m\n", m_evictedLines);
+    }
+    for (const auto& data : m_backlog) combined += *data;
+
+    m_appender.append(combined);
+
+    m_backlog.clear();
+    m_backlog.shrink_to_fit();
+    m_backlogBytes = 0;
+}
+
+void TerminalSink::consume(const std::vector<SinkData>& batch) {
+    std::lock_guard lock(m_backlogMutex);
+    if (m_open) return FileSink::consume(batch);
+
+    for (const auto& data : batch) {
+        m_backlog.push_back(data);
+        m_backlogBytes += data->size();
+    }
+    while (m_backlogBytes > MAX_BACKLOG_BYTES && !m_backlog.empty()) {
+        m_backlogBytes -= m_backlog.front()->size();
+        m_backlog.pop_front();
+        m_evictedLines++;
+    }
+}
+
+PlainFileSink::PlainFileSink(const std::filesystem::path& path) : FileSink("log file", SinkEncoding::Plain, path) {}
+
+Severity PlainFileSink::getThreshold() {
+    return Config::get()->getSettings()->logFileLevel;
+}
+
+SyslogSink::SyslogSink(const std::filesystem::path& path) : FileSink("syslog", SinkEncoding::Syslog, path) {}
+
+Severity SyslogSink::getThreshold() {
+    return Config::get()->getSettings()->syslogLevel;
+}
+
+LoopbackSink::LoopbackSink(int port) : LogSink("loopback", SinkEncoding::Ansi), m_port(port) {
+    WSADATA wsaData;
+    if (WSAStartup(MAKEWORD(2, 2), &wsaData) != 0) {
+        log::error("Failed to start winsock for the loopback log sink");
+        return;
+    }
+
+    m_socket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (m_socket == INVALID_SOCKET) log::error("Failed to create loopback log socket: {}", WSAGetLastError());
+}
+
+LoopbackSink::~LoopbackSink() {
+    if (m_socket != INVALID_SOCKET) closesocket(static_cast<SOCKET>(m_socket));
+    WSACleanup();
+}
+
+Severity LoopbackSink::getThreshold() {
+    return Config::get()->getSettings()->loopbackLevel;
+}
+
+// One datagram per line, so anything listening with `nc -ul` gets whole lines.
+void LoopbackSink::consume(const std::vector<SinkData>& batch) {
+    if (m_socket == INVALID_SOCKET) return;
+
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(static_cast<u_short>(m_port));
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    for (const auto& data : batch) {
+        sendto(static_cast<SOCKET>(m_socket), data->data(), static_cast<int>(data->size()), 0, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+    }
+}
+
+ArchiveSink::ArchiveSink() : LogSink("archive", SinkEncoding::Ansi, SinkOverflow::Block) {}
+
+Severity ArchiveSink::getThreshold() {
+    return Config::get()->getSettings()->consoleLogLevel;
+}
+
+void ArchiveSink::consume(const std::vector<SinkData>& batch) {
+    for (const auto& data : batch) {
+        LogArchive::get()->push(*data);
+    }
+}
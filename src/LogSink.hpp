@@ -0,0 +1,155 @@
+#pragma once
+
+#include <Geode/loader/Log.hpp>
+#include <array>
+#include <cstdint>
+#include <condition_variable>
+#include <deque>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "FileAppender.hpp"
+
+enum class SinkEncoding {
+    Ansi,
+    Plain,
+    Syslog,
+    Count
+};
+
+// What a sink does with a line when its queue is full.
+enum class SinkOverflow {
+    Drop,
+    Block
+};
+
+using SinkData = std::shared_ptr<const std::string>;
+
+/*
+    A formatted log line. Each encoding is built the first time a sink asks for it, and every
+    sink after that shares the same string, so a line is never formatted twice for the same output.
+*/
+class LogRecord {
+public:
+    LogRecord(geode::Severity severity, std::string_view formatted, std::string_view tagPrefix);
+
+    geode::Severity getSeverity() const;
+    std::string_view getFormatted() const;
+    const SinkData& get(SinkEncoding encoding);
+
+private:
+    geode::Severity m_severity;
+    std::string_view m_formatted;
+    std::string_view m_tagPrefix;
+    std::array<SinkData, static_cast<size_t>(SinkEncoding::Count)> m_encoded;
+};
+
+/*
+    Every sink owns a bounded queue and a thread that drains it, so a slow sink only ever
+    holds up itself. When the queue of an optional sink is full, new lines for it are dropped and
+    counted. The terminal and the archive can't lose lines, so they make the logging thread wait
+    for room instead, which only happens when something floods them faster than a file append.
+*/
+class LogSink {
+public:
+    LogSink(std::string name, SinkEncoding encoding, SinkOverflow overflow = SinkOverflow::Drop);
+    virtual ~LogSink() = default;
+
+    virtual geode::Severity getThreshold() = 0;
+
+    void start();
+    void enqueue(SinkData data);
+    SinkEncoding getEncoding() const;
+    const std::string& getName() const;
+
+protected:
+    virtual void consume(const std::vector<SinkData>& batch) = 0;
+
+private:
+    static constexpr size_t MAX_QUEUED = 4096;
+    static constexpr size_t MAX_QUEUED_BYTES = 16 * 1024 * 1024;
+
+    std::string m_name;
+    SinkEncoding m_encoding;
+    SinkOverflow m_overflow;
+    std::deque<SinkData> m_queue;
+    size_t m_queuedBytes = 0;
+    // set once the thread has exited, after that nothing will make room in the queue
+    bool m_stopped = false;
+    std::mutex m_mutex;
+    std::condition_variable_any m_condition;
+    std::condition_variable m_drained;
+};
+
+class FileSink : public LogSink {
+public:
+    FileSink(std::string name, SinkEncoding encoding, const std::filesystem::path& path, SinkOverflow overflow = SinkOverflow::Drop);
+
+protected:
+    void consume(const std::vector<SinkData>& batch) override;
+
+    FileAppender m_appender;
+};
+
+/*
+    Until the console is opened, lines are held in a ring instead of the file. Opening writes the
+    ring out in one go, so the terminal starts with everything that still fits instead of the last few lines.
+*/
+class TerminalSink : public FileSink {
+public:
+    TerminalSink(const std::filesystem::path& path, bool open);
+    geode::Severity getThreshold() override;
+
+    void open();
+
+protected:
+    void consume(const std::vector<SinkData>& batch) override;
+
+private:
+    static constexpr size_t MAX_BACKLOG_BYTES = 4 * 1024 * 1024;
+
+    std::deque<SinkData> m_backlog;
+    size_t m_backlogBytes = 0;
+    size_t m_evictedLines = 0;
+    bool m_open;
+    std::mutex m_backlogMutex;
+};
+
+class PlainFileSink : public FileSink {
+public:
+    PlainFileSink(const std::filesystem::path& path);
+    geode::Severity getThreshold() override;
+};
+
+class SyslogSink : public FileSink {
+public:
+    SyslogSink(const std::filesystem::path& path);
+    geode::Severity getThreshold() override;
+};
+
+class LoopbackSink : public LogSink {
+public:
+    LoopbackSink(int port);
+    ~LoopbackSink() override;
+    geode::Severity getThreshold() override;
+
+protected:
+    void consume(const std::vector<SinkData>& batch) override;
+
+private:
+    // a SOCKET, kept as an integer so winsock headers don't leak out of LogSink.cpp
+    uintptr_t m_socket = ~uintptr_t{0};
+    int m_port;
+};
+
+class ArchiveSink : public LogSink {
+public:
+    ArchiveSink();
+    geode::Severity getThreshold() override;
+
+protected:
+    void consume(const std::vector<SinkData>& batch) override;
+};
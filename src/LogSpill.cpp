@@ -0,0 +1,105 @@
+#include <Geode/Geode.hpp>
+#include <fstream>
+#include "LogSpill.hpp"
+#include "Config.hpp"
+#include "ThreadRegistry.hpp"
+#include "Trace.hpp"
+#include "Utils.hpp"
+
+using namespace geode::prelude;
+
+LogSpill* LogSpill::get() {
+    static LogSpill instance;
+    return &instance;
+}
+
+// Moves a cut point back off UTF-8 continuation bytes, so a character is never split in half.
+static size_t toBoundary(std::string_view str, size_t index) {
+    while (index > 0 && index < str.size() && (static_cast<uint8_t>(str[index]) & 0xC0) == 0x80) index--;
+    return index;
+}
+
+/*
+    Most of the cap goes to the start of the message, since that's usually where the useful part is,
+    and the rest to the end so it's still clear how it finished.
+*/
+std::string LogSpill::truncate(std::string_view formatted, size_t cap) {
+    TraceSpan span("log truncate", "console");
+
+    auto headEnd = toBoundary(formatted, cap * 3 / 4);
+    auto tailStart = std::max(headEnd, toBoundary(formatted, formatted.size() - cap / 4));
+    auto cut = tailStart - headEnd;
+
+    std::string marker;
+    if (Config::get()->getSettings()->spillOversized) {
+        auto path = spill(formatted);
+        marker = path.empty()
+            ? fmt::format("\n[... {} cut, too much is waiting to be spilled already ...]\n", sobriety::utils::formatBytes(cut))
+            : fmt::format("\n[... {} cut, full message in {} ...]\n", sobriety::utils::formatBytes(cut), utils::string::pathToString(path));
+    }
+    else {
+        marker = fmt::format("\n[... {} cut ...]\n", sobriety::utils::formatBytes(cut));
+    }
+
+    std::string result;
+    result.reserve(headEnd + marker.size() + formatted.size() - tailStart);
+    result.append(formatted.substr(0, headEnd));
+    result.append(marker);
+    result.append(formatted.substr(tailStart));
+    return result;
+}
+
+std::filesystem::path LogSpill::spill(std::string_view payload) {
+    std::lock_guard lock(m_mutex);
+    if (m_queuedBytes + payload.size() > MAX_QUEUED_BYTES) return {};
+
+    if (!m_started) start();
+
+    auto path = Config::get()->getUniquePath() / "spill" / fmt::format("message-{}.log", m_nextId++);
+    m_queue.push_back({path, std::make_shared<const std::string>(payload)});
+    m_queuedBytes += payload.size();
+    m_condition.notify_one();
+    return path;
+}
+
+void LogSpill::start() {
+    m_started = true;
+
+    std::error_code ec;
+    std::filesystem::create_directories(Config::get()->getUniquePath() / "spill", ec);
+    if (ec) log::error("Failed to create spill directory: {}", ec.message());
+
+    ThreadRegistry::get()->spawn({ .name = "log spill", .priority = ThreadPriority::Low }, [this](std::stop_token token) {
+        while (true) {
+            SpillFile file;
+            {
+                std::unique_lock lock(m_mutex);
+                m_condition.wait(lock, token, [this] { return !m_queue.empty(); });
+                if (m_queue.empty()) return;
+
+                file = std::move(m_queue.front());
+                m_queue.pop_front();
+            }
+
+            write(file);
+
+            std::lock_guard lock(m_mutex);
+            m_queuedBytes -= file.payload->size();
+        }
+    });
+}
+
+// Written a chunk at a time so a huge payload never sits in one giant write.
+void LogSpill::write(const SpillFile& file) {
+    TraceSpan span("log spill", "console", utils::string::pathToString(file.path.filename()));
+
+    std::ofstream stream(file.path, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!stream.is_open()) return log::error("Failed to create spill file {}", file.path);
+
+    std::string_view payload = *file.payload;
+    for (size_t offset = 0; offset < payload.size(); offset += CHUNK_SIZE) {
+        auto chunk = payload.substr(offset, CHUNK_SIZE);
+        stream.write(chunk.data(), chunk.size());
+    }
+    stream.put('\n');
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+
+struct SpillFile {
+    std::filesystem::path path;
+    std::shared_ptr<const std::string> payload;
+};
+
+/*
+    Messages over the size cap are cut down to their start and end before anything else touches them,
+    so a mod dumping a huge response body doesn't hold up every sink and the terminal. If spilling is on,
+    the whole message is written to its own file in chunks on a background thread, and the cut says where.
+*/
+class LogSpill {
+public:
+    static LogSpill* get();
+
+    std::string truncate(std::string_view formatted, size_t cap);
+
+private:
+    static constexpr size_t CHUNK_SIZE = 64 * 1024;
+    static constexpr size_t MAX_QUEUED_BYTES = 64 * 1024 * 1024;
+
+    std::filesystem::path spill(std::string_view payload);
+    void start();
+    void write(const SpillFile& file);
+
+    std::deque<SpillFile> m_queue;
+    size_t m_queuedBytes = 0;
+    uint64_t m_nextId = 0;
+    bool m_started = false;
+    std::mutex m_mutex;
+    std::condition_variable_any m_condition;
+};
@@ -0,0 +1,213 @@
+#include <Geode/Geode.hpp>
+#include <algorithm>
+#include "LogVolume.hpp"
+#include "Sanitizer.hpp"
+#include "Utils.hpp"
+
+using namespace geode::prelude;
+
+LogVolume* LogVolume::get() {
+    static LogVolume instance;
+    return &instance;
+}
+
+static uint64_t mix(uint64_t value) {
+    value ^= value >> 30;
+    value *= 0xbf58476d1ce4e5b9;
+    value ^= value >> 27;
+    value *= 0x94d049bb133111eb;
+    value ^= value >> 31;
+    return value;
+}
+
+static bool isNumberPart(char c) {
+    return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F') || c == 'x' || c == '.';
+}
+
+static std::string formatDuration(std::chrono::steady_clock::duration duration) {
+    auto seconds = std::chrono::duration_cast<std::chrono::seconds>(duration).count();
+    if (seconds >= 3600) return fmt::format("{}h {}m", seconds / 3600, seconds % 3600 / 60);
+    if (seconds >= 60) return fmt::format("{}m {}s", seconds / 60, seconds % 60);
+    return fmt::format("{}s", seconds);
+}
+
+/*
+    "Loaded 12 textures in 3.5ms" and "Loaded 40 textures in 0.9ms" come from the same line of code, so any
+    run starting with a digit (including hex and decimals) counts as one character. Only the start of the
+    message is looked at, it's enough to tell lines apart and a huge message costs the same as a short one.
+*/
+uint64_t LogVolume::hashSite(Mod* mod, std::string_view message) {
+    uint64_t hash = 0xcbf29ce484222325 ^ mix(reinterpret_cast<uintptr_t>(mod));
+    auto length = std::min<size_t>(message.size(), 256);
+
+    for (size_t i = 0; i < length; i++) {
+        auto c = message[i];
+        if (c >= '0' && c <= '9') {
+            while (i + 1 < length && isNumberPart(message[i + 1])) i++;
+            c = '#';
+        }
+        hash ^= static_cast<uint8_t>(c);
+        hash *= 0x100000001b3;
+    }
+    return hash;
+}
+
+size_t LogVolume::getSketchIndex(uint64_t site, size_t row) {
+    return mix(site + (row + 1) * 0x9e3779b97f4a7c15) & (SKETCH_WIDTH - 1);
+}
+
+// Mods are never unloaded, so a slot claimed for one stays theirs and the table needs no lock.
+ModVolume& LogVolume::getModVolume(Mod* mod) {
+    if (!mod) return m_unknown;
+
+    auto index = mix(reinterpret_cast<uintptr_t>(mod)) & (MOD_SLOTS - 1);
+    for (size_t probe = 0; probe < MOD_SLOTS; probe++) {
+        auto& slot = m_mods[(index + probe) & (MOD_SLOTS - 1)];
+
+        Mod* current = slot.mod.load(std::memory_order_acquire);
+        if (!current && slot.mod.compare_exchange_strong(current, mod, std::memory_order_acq_rel)) return slot;
+        if (current == mod) return slot;
+    }
+    return m_unknown;
+}
+
+// Returns the site's line count, which like every count from the sketch can be a little high but never low.
+uint32_t LogVolume::countSite(uint64_t site, size_t bytes) {
+    uint32_t lines = UINT32_MAX;
+    for (size_t row = 0; row < SKETCH_DEPTH; row++) {
+        auto index = getSketchIndex(site, row);
+        lines = std::min(lines, m_siteLines[row][index].fetch_add(1, std::memory_order_relaxed) + 1);
+        m_siteBytes[row][index].fetch_add(bytes, std::memory_order_relaxed);
+    }
+    return lines;
+}
+
+uint32_t LogVolume::estimateLines(uint64_t site) const {
+    uint32_t lines = UINT32_MAX;
+    for (size_t row = 0; row < SKETCH_DEPTH; row++) {
+        lines = std::min(lines, m_siteLines[row][getSketchIndex(site, row)].load(std::memory_order_relaxed));
+    }
+    return lines;
+}
+
+uint64_t LogVolume::estimateBytes(uint64_t site) const {
+    uint64_t bytes = UINT64_MAX;
+    for (size_t row = 0; row < SKETCH_DEPTH; row++) {
+        bytes = std::min(bytes, m_siteBytes[row][getSketchIndex(site, row)].load(std::memory_order_relaxed));
+    }
+    return bytes;
+}
+
+/*
+    Called on every log event from whatever thread logged it, so it's a handful of relaxed atomic adds.
+    The lock for the heaviest sites is only taken every 16th line of a site that's already heavy enough
+    to make the table.
+*/
+void LogVolume::record(Mod* mod, std::string_view message) {
+    auto& volume = getModVolume(mod);
+    volume.lines.fetch_add(1, std::memory_order_relaxed);
+    volume.bytes.fetch_add(message.size(), std::memory_order_relaxed);
+
+    auto site = hashSite(mod, message);
+    auto lines = countSite(site, message.size());
+
+    if (lines % 16 == 0 && lines >= m_topThreshold.load(std::memory_order_relaxed)) {
+        trackSite(site, mod, message, lines);
+    }
+}
+
+void LogVolume::trackSite(uint64_t site, Mod* mod, std::string_view message, uint32_t lines) {
+    std::lock_guard lock(m_topMutex);
+
+    if (std::ranges::any_of(m_topSites, [site](const TopSite& top) { return top.site == site; })) return;
+
+    auto sample = message.substr(0, std::min(message.find('\n'), SAMPLE_LENGTH));
+    while (sample.size() < message.size() && !sample.empty() && (static_cast<uint8_t>(message[sample.size()]) & 0xC0) == 0x80) {
+        sample.remove_suffix(1);
+    }
+
+    if (m_topSites.size() < TOP_SITES) {
+        m_topSites.push_back({site, mod, std::string(sample)});
+    }
+    else {
+        auto lightest = std::ranges::min_element(m_topSites, {}, [this](const TopSite& top) { return estimateLines(top.site); });
+        if (estimateLines(lightest->site) >= lines) return;
+        *lightest = {site, mod, std::string(sample)};
+    }
+
+    if (m_topSites.size() == TOP_SITES) {
+        uint32_t threshold = UINT32_MAX;
+        for (const auto& top : m_topSites) threshold = std::min(threshold, estimateLines(top.site));
+        m_topThreshold.store(threshold, std::memory_order_relaxed);
+    }
+}
+
+std::vector<std::string> LogVolume::report(size_t count) {
+    struct ModReport {
+        std::string id;
+        uint64_t lines;
+        uint64_t bytes;
+        uint64_t recentLines;
+    };
+
+    std::lock_guard lock(m_reportMutex);
+    auto now = std::chrono::steady_clock::now();
+    auto sessionSeconds = std::max(std::chrono::duration<double>(now - m_start).count(), 1.0);
+    auto recentSeconds = std::max(std::chrono::duration<double>(now - m_lastReport).count(), 1.0);
+    m_lastReport = now;
+
+    std::vector<ModReport> mods;
+    uint64_t totalLines = 0;
+    uint64_t totalBytes = 0;
+    auto collect = [&](ModVolume& volume, std::string id) {
+        auto lines = volume.lines.load(std::memory_order_relaxed);
+        if (lines == 0) return;
+
+        mods.push_back({std::move(id), lines, volume.bytes.load(std::memory_order_relaxed), lines - volume.reportedLines});
+        volume.reportedLines = lines;
+        totalLines += lines;
+        totalBytes += mods.back().bytes;
+    };
+    for (auto& volume : m_mods) {
+        if (auto mod = volume.mod.load(std::memory_order_acquire)) collect(volume, mod->getID());
+    }
+    collect(m_unknown, "unknown");
+
+    if (mods.empty()) return { "Nothing has been logged yet" };
+
+    std::ranges::sort(mods, std::ranges::greater{}, &ModReport::lines);
+    if (mods.size() > count) mods.resize(count);
+
+    std::vector<std::string> lines;
+    lines.push_back(fmt::format("Log volume over {}: {} lines, {}",
+        formatDuration(now - m_start), totalLines, sobriety::utils::formatBytes(totalBytes)
+    ));
+    for (const auto& mod : mods) {
+        lines.push_back(fmt::format("  {}: {} lines ({:.0f}%), {}, {:.1f} lines/s overall, {:.1f} lines/s since the last report",
+            mod.id, mod.lines, 100.0 * mod.lines / totalLines, sobriety::utils::formatBytes(mod.bytes),
+            mod.lines / sessionSeconds, mod.recentLines / recentSeconds
+        ));
+    }
+
+    std::vector<TopSite> sites;
+    {
+        std::lock_guard topLock(m_topMutex);
+        sites = m_topSites;
+    }
+    if (sites.empty()) return lines;
+
+    std::vector<std::pair<uint32_t, const TopSite*>> ranked;
+    for (const auto& site : sites) ranked.emplace_back(estimateLines(site.site), &site);
+    std::ranges::sort(ranked, std::ranges::greater{}, &std::pair<uint32_t, const TopSite*>::first);
+    if (ranked.size() > count) ranked.resize(count);
+
+    lines.push_back("Busiest lines (counts are upper bounds):");
+    for (const auto& [estimate, site] : ranked) {
+        auto sample = sobriety::sanitizer::isClean(site->sample) ? site->sample : sobriety::sanitizer::sanitize(site->sample);
+        lines.push_back(fmt::format("  {}: ~{} lines, ~{}, {:.1f} lines/s: \"{}\"",
+            site->mod ? site->mod->getID() : "unknown", estimate,
+            sobriety::utils::formatBytes(estimateBytes(site->site)), estimate / sessionSeconds, sample
+        ));
+    }
+    return lines;
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <Geode/loader/Mod.hpp>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+struct ModVolume {
+    std::atomic<geode::Mod*> mod = nullptr;
+    std::atomic<uint64_t> lines = 0;
+    std::atomic<uint64_t> bytes = 0;
+
+    // only touched by the report, to show the rate since the last one
+    uint64_t reportedLines = 0;
+};
+
+struct TopSite {
+    uint64_t site;
+    geode::Mod* mod;
+    std::string sample;
+};
+
+/*
+    Counts what every mod logs, whether or not it ends up shown, so a mod flooding the log can be found and
+    pointed at. Mods get exact counters in a fixed table. Call sites don't exist in a log event, so a site is
+    the mod plus the message with its numbers taken out, and those are counted in a count-min sketch so memory
+    stays fixed no matter how many different messages there are. A small table remembers which sites are the
+    heaviest so the report has something to name.
+*/
+class LogVolume {
+public:
+    static LogVolume* get();
+
+    void record(geode::Mod* mod, std::string_view message);
+    std::vector<std::string> report(size_t count);
+
+private:
+    static constexpr size_t MOD_SLOTS = 512;
+    static constexpr size_t SKETCH_DEPTH = 4;
+    static constexpr size_t SKETCH_WIDTH = 4096;
+    static constexpr size_t TOP_SITES = 16;
+    static constexpr size_t SAMPLE_LENGTH = 72;
+
+    static uint64_t hashSite(geode::Mod* mod, std::string_view message);
+    static size_t getSketchIndex(uint64_t site, size_t row);
+
+    ModVolume& getModVolume(geode::Mod* mod);
+    uint32_t countSite(uint64_t site, size_t bytes);
+    uint32_t estimateLines(uint64_t site) const;
+    uint64_t estimateBytes(uint64_t site) const;
+    void trackSite(uint64_t site, geode::Mod* mod, std::string_view message, uint32_t lines);
+
+    std::array<ModVolume, MOD_SLOTS> m_mods;
+    ModVolume m_unknown;
+
+    std::array<std::array<std::atomic<uint32_t>, SKETCH_WIDTH>, SKETCH_DEPTH> m_siteLines{};
+    std::array<std::array<std::atomic<uint64_t>, SKETCH_WIDTH>, SKETCH_DEPTH> m_siteBytes{};
+
+    std::vector<TopSite> m_topSites;
+    std::atomic<uint32_t> m_topThreshold = 0;
+    std::mutex m_topMutex;
+
+    std::chrono::steady_clock::time_point m_start = std::chrono::steady_clock::now();
+    std::chrono::steady_clock::time_point m_lastReport = m_start;
+    std::mutex m_reportMutex;
+};
@@ -0,0 +1,153 @@
+#include <Geode/Geode.hpp>
+#include "Mailbox.hpp"
+#include "Metrics.hpp"
+#include "Trace.hpp"
+
+using namespace geode::prelude;
+
+Mailbox* Mailbox::get() {
+    static Mailbox instance;
+    return &instance;
+}
+
+Mailbox::Mailbox() : m_head(&m_stub), m_tail(&m_stub) {
+    for (uint32_t i = 0; i < POOL_SIZE; i++) {
+        m_pool[i].poolIndex = i;
+        m_freeNext[i].store(i + 1 < POOL_SIZE ? i + 1 : NO_NODE, std::memory_order_relaxed);
+    }
+    m_freeHead.store(0, std::memory_order_release);
+}
+
+uint64_t Mailbox::keyFor(std::string_view name) {
+    return std::hash<std::string_view>{}(name);
+}
+
+MailNode* Mailbox::acquire() {
+    auto head = m_freeHead.load(std::memory_order_acquire);
+    while (static_cast<uint32_t>(head) != NO_NODE) {
+        auto index = static_cast<uint32_t>(head);
+        auto next = m_freeNext[index].load(std::memory_order_relaxed);
+        auto tag = (head >> 32) + 1;
+
+        if (m_freeHead.compare_exchange_weak(head, (tag << 32) | next, std::memory_order_acq_rel, std::memory_order_acquire)) {
+            return &m_pool[index];
+        }
+    }
+    return new MailNode();
+}
+
+void Mailbox::release(MailNode* node) {
+    node->task.reset();
+    if (node->poolIndex == NO_NODE) {
+        delete node;
+        return;
+    }
+
+    auto head = m_freeHead.load(std::memory_order_relaxed);
+    while (true) {
+        m_freeNext[node->poolIndex].store(static_cast<uint32_t>(head), std::memory_order_relaxed);
+        auto tag = (head >> 32) + 1;
+        if (m_freeHead.compare_exchange_weak(head, (tag << 32) | node->poolIndex, std::memory_order_release, std::memory_order_relaxed)) return;
+    }
+}
+
+void Mailbox::push(MailNode* node) {
+    Metrics::get()->add(Metrics::get()->mainThreadCallbacks);
+    link(node);
+}
+
+// Producers only swap the head and link the previous node to theirs, it never has to retry.
+void Mailbox::link(MailNode* node) {
+    node->next.store(nullptr, std::memory_order_relaxed);
+    auto prev = m_head.exchange(node, std::memory_order_acq_rel);
+    prev->next.store(node, std::memory_order_release);
+}
+
+/*
+    Only ever called from the main thread. A node whose producer has swapped the head but not linked it yet
+    reads as empty, it'll be picked up next frame.
+*/
+MailNode* Mailbox::pop() {
+    auto tail = m_tail;
+    auto next = tail->next.load(std::memory_order_acquire);
+
+    if (tail == &m_stub) {
+        if (!next) return nullptr;
+        m_tail = next;
+        tail = next;
+        next = next->next.load(std::memory_order_acquire);
+    }
+
+    if (next) {
+        m_tail = next;
+        return tail;
+    }
+
+    if (tail != m_head.load(std::memory_order_acquire)) return nullptr;
+
+    link(&m_stub);
+    next = tail->next.load(std::memory_order_acquire);
+    if (next) {
+        m_tail = next;
+        return tail;
+    }
+    return nullptr;
+}
+
+// Moves everything posted so far into the pending list, a keyed task takes the place of the one it replaces.
+void Mailbox::collect() {
+    auto metrics = Metrics::get();
+
+    while (auto node = pop()) {
+        if (!node->keyed) {
+            m_pending.push_back(node);
+            continue;
+        }
+
+        auto [iter, inserted] = m_pendingKeys.try_emplace(node->key, m_pending.size());
+        if (inserted) {
+            m_pending.push_back(node);
+            continue;
+        }
+
+        release(std::exchange(m_pending[iter->second], node));
+        metrics->add(metrics->mailboxSuperseded);
+    }
+}
+
+void Mailbox::drain(std::chrono::microseconds budget) {
+    collect();
+    if (m_pendingStart == m_pending.size()) return;
+
+    TraceSpan span("mailbox drain", "scheduler");
+    auto start = std::chrono::steady_clock::now();
+
+    // at least one task runs every frame, however long it takes, so nothing waits forever
+    do {
+        auto node = m_pending[m_pendingStart++];
+        if (node->keyed) m_pendingKeys.erase(node->key);
+
+        node->task();
+        release(node);
+    } while (m_pendingStart < m_pending.size() && std::chrono::steady_clock::now() - start < budget);
+
+    if (m_pendingStart == m_pending.size()) {
+        m_pending.clear();
+        m_pendingStart = 0;
+        return;
+    }
+
+    auto metrics = Metrics::get();
+    metrics->add(metrics->mailboxDeferred, m_pending.size() - m_pendingStart);
+
+    // only compacted once the finished part is most of it, the key positions have to be rebuilt
+    if (m_pendingStart > m_pending.size() / 2) {
+        m_pending.erase(m_pending.begin(), m_pending.begin() + m_pendingStart);
+        m_pendingStart = 0;
+
+        m_pendingKeys.clear();
+        for (size_t i = 0; i < m_pending.size(); i++) {
+            if (m_pending[i]->keyed) m_pendingKeys[m_pending[i]->key] = i;
+        }
+    }
+}
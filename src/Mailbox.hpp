@@ -0,0 +1,121 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/*
+    A callable stored inside the node it was posted with, so posting never allocates a wrapper for it.
+    Whatever the task captures still owns its own memory, a captured string is moved in as it is.
+*/
+class MailTask {
+public:
+    static constexpr size_t CAPACITY = 96;
+
+    MailTask() = default;
+    MailTask(const MailTask&) = delete;
+    MailTask& operator=(const MailTask&) = delete;
+    ~MailTask() { reset(); }
+
+    template <class F>
+    void emplace(F&& task) {
+        using T = std::decay_t<F>;
+        static_assert(sizeof(T) <= CAPACITY, "task captures too much to fit in a mailbox node");
+        static_assert(alignof(T) <= alignof(std::max_align_t), "task is over aligned for a mailbox node");
+
+        reset();
+        new (m_storage) T(std::forward<F>(task));
+        m_invoke = [](void* storage) { (*static_cast<T*>(storage))(); };
+        m_destroy = [](void* storage) { static_cast<T*>(storage)->~T(); };
+    }
+
+    void operator()() { m_invoke(m_storage); }
+
+    void reset() {
+        if (m_destroy) m_destroy(m_storage);
+        m_invoke = nullptr;
+        m_destroy = nullptr;
+    }
+
+private:
+    alignas(std::max_align_t) unsigned char m_storage[CAPACITY];
+    void (*m_invoke)(void*) = nullptr;
+    void (*m_destroy)(void*) = nullptr;
+};
+
+struct MailNode {
+    std::atomic<MailNode*> next = nullptr;
+    MailTask task;
+    uint64_t key = 0;
+    bool keyed = false;
+    uint32_t poolIndex = UINT32_MAX;
+};
+
+/*
+    Work handed to the main thread by the mod's own threads. Any thread can post without a lock, the main
+    thread drains it once a frame from the scheduler and stops once the frame's budget is spent, leaving the
+    rest for the next one. Nodes come from a fixed pool and only fall back to the heap if it runs dry.
+
+    A task posted with a key replaces one with the same key that hasn't run yet, so a file changing ten
+    times in a frame is handled once, with its latest contents.
+*/
+class Mailbox {
+public:
+    static Mailbox* get();
+
+    static uint64_t keyFor(std::string_view name);
+
+    template <class F>
+    void post(F&& task) {
+        auto node = acquire();
+        node->task.emplace(std::forward<F>(task));
+        node->keyed = false;
+        push(node);
+    }
+
+    template <class F>
+    void post(uint64_t key, F&& task) {
+        auto node = acquire();
+        node->task.emplace(std::forward<F>(task));
+        node->key = key;
+        node->keyed = true;
+        push(node);
+    }
+
+    void drain(std::chrono::microseconds budget);
+
+private:
+    static constexpr uint32_t POOL_SIZE = 512;
+    static constexpr uint32_t NO_NODE = UINT32_MAX;
+
+    Mailbox();
+
+    MailNode* acquire();
+    void release(MailNode* node);
+    void push(MailNode* node);
+    void link(MailNode* node);
+    MailNode* pop();
+    void collect();
+
+    std::array<MailNode, POOL_SIZE> m_pool;
+    std::array<std::atomic<uint32_t>, POOL_SIZE> m_freeNext;
+    // the low half is the first free node, the high half a tag bumped on every change so a stale pop fails
+    std::atomic<uint64_t> m_freeHead;
+
+    MailNode m_stub;
+    std::atomic<MailNode*> m_head;
+    MailNode* m_tail;
+
+    // only touched by the main thread
+    std::vector<MailNode*> m_pending;
+    size_t m_pendingStart = 0;
+    std::unordered_map<uint64_t, size_t> m_pendingKeys;
+};
@@ -0,0 +1,6 @@
+#include "Metrics.hpp"
+
+Metrics* Metrics::get() {
+    static Metrics instance;
+    return &instance;
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+/*
+    Counters bumped from any thread by the mod's subsystems. Everything is relaxed since they are only
+    ever read to show rates, so being off by a line or two between frames doesn't matter.
+*/
+struct Metrics {
+    std::atomic<uint64_t> logLines = 0;
+    std::atomic<uint64_t> logBytes = 0;
+    std::atomic<uint64_t> suppressedLines = 0;
+    std::atomic<uint64_t> droppedLines = 0;
+    std::atomic<uint64_t> sanitizedLines = 0;
+    std::atomic<uint64_t> truncatedLines = 0;
+    std::atomic<uint64_t> watcherEvents = 0;
+    std::atomic<uint64_t> watcherSkipped = 0;
+    std::atomic<uint64_t> mainThreadCallbacks = 0;
+    std::atomic<uint64_t> mailboxSuperseded = 0;
+    std::atomic<uint64_t> mailboxDeferred = 0;
+    std::atomic<uint64_t> frames = 0;
+    std::atomic<uint64_t> hookNanoseconds = 0;
+    std::atomic<long long> heartbeatAge = -1;
+    std::atomic<double> heartbeatJitter = 0;
+
+    static Metrics* get();
+
+    void add(std::atomic<uint64_t>& counter, uint64_t amount = 1) {
+        counter.fetch_add(amount, std::memory_order_relaxed);
+    }
+};
+
+// Adds the time spent in a hook for as long as it is in scope
+class HookTimer {
+public:
+    HookTimer() : m_start(std::chrono::steady_clock::now()) {}
+
+    ~HookTimer() {
+        auto elapsed = std::chrono::steady_clock::now() - m_start;
+        Metrics::get()->add(Metrics::get()->hookNanoseconds, std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+    }
+
+private:
+    std::chrono::steady_clock::time_point m_start;
+};
@@ -0,0 +1,104 @@
+#include "PerformanceOverlay.hpp"
+#include "Metrics.hpp"
+#include "Scheduler.hpp"
+#include <Geode/Geode.hpp>
+#include <Geode/ui/OverlayManager.hpp>
+
+using namespace geode::prelude;
+
+PerformanceOverlay* PerformanceOverlay::s_instance = nullptr;
+
+PerformanceOverlay* PerformanceOverlay::create() {
+    auto ret = new PerformanceOverlay();
+    if (ret->init()) {
+        ret->autorelease();
+        return ret;
+    }
+    delete ret;
+    return nullptr;
+}
+
+bool PerformanceOverlay::init() {
+    if (!CCNode::init()) return false;
+
+    auto winSize = CCDirector::get()->getWinSize();
+
+    setAnchorPoint({0.f, 1.f});
+    setPosition({5.f, winSize.height - 5.f});
+    setZOrder(INT_MAX);
+
+    m_label = CCLabelBMFont::create("", "chatFont.fnt");
+    m_label->setAnchorPoint({0.f, 1.f});
+    m_label->setScale(0.5f);
+    m_label->setOpacity(200);
+    addChild(m_label);
+
+    m_lastSnapshot = takeSnapshot();
+
+    return true;
+}
+
+void PerformanceOverlay::setEnabled(bool enabled) {
+    if (enabled && !s_instance) {
+        s_instance = PerformanceOverlay::create();
+        OverlayManager::get()->addChild(s_instance);
+
+        Scheduler::get()->schedule("performance-overlay", [] {
+            if (s_instance) s_instance->refresh();
+        }, std::chrono::milliseconds(500));
+    }
+    else if (!enabled && s_instance) {
+        Scheduler::get()->unschedule("performance-overlay");
+        s_instance->removeFromParent();
+        s_instance = nullptr;
+    }
+}
+
+MetricsSnapshot PerformanceOverlay::takeSnapshot() {
+    auto metrics = Metrics::get();
+    return {
+        metrics->logLines.load(std::memory_order_relaxed),
+        metrics->logBytes.load(std::memory_order_relaxed),
+        metrics->suppressedLines.load(std::memory_order_relaxed),
+        metrics->droppedLines.load(std::memory_order_relaxed),
+        metrics->watcherEvents.load(std::memory_order_relaxed),
+        metrics->mainThreadCallbacks.load(std::memory_order_relaxed),
+        metrics->frames.load(std::memory_order_relaxed),
+        metrics->hookNanoseconds.load(std::memory_order_relaxed),
+        std::chrono::steady_clock::now()
+    };
+}
+
+void PerformanceOverlay::refresh() {
+    auto snapshot = takeSnapshot();
+
+    double seconds = std::chrono::duration<double>(snapshot.time - m_lastSnapshot.time).count();
+    if (seconds <= 0) return;
+
+    uint64_t frames = snapshot.frames - m_lastSnapshot.frames;
+    auto perFrame = [frames](uint64_t value) {
+        return frames > 0 ? static_cast<double>(value) / frames : 0.0;
+    };
+
+    auto heartbeatAge = Metrics::get()->heartbeatAge.load(std::memory_order_relaxed);
+
+    m_label->setString(fmt::format(
+        "Log: {:.0f} lines/s, {:.1f} KiB/s\n"
+        "Suppressed: {:.0f} lines/s, dropped {:.0f} lines/s\n"
+        "Heartbeat: {}, jitter {:.1f}ms\n"
+        "Watcher: {:.1f} events/s\n"
+        "Main thread: {:.2f} callbacks/frame\n"
+        "Hooks: {:.3f}ms/frame",
+        (snapshot.logLines - m_lastSnapshot.logLines) / seconds,
+        (snapshot.logBytes - m_lastSnapshot.logBytes) / seconds / 1024.0,
+        (snapshot.suppressedLines - m_lastSnapshot.suppressedLines) / seconds,
+        (snapshot.droppedLines - m_lastSnapshot.droppedLines) / seconds,
+        heartbeatAge >= 0 ? fmt::format("{}ms old", heartbeatAge) : "inactive",
+        Metrics::get()->heartbeatJitter.load(std::memory_order_relaxed),
+        (snapshot.watcherEvents - m_lastSnapshot.watcherEvents) / seconds,
+        perFrame(snapshot.mainThreadCallbacks - m_lastSnapshot.mainThreadCallbacks),
+        perFrame(snapshot.hookNanoseconds - m_lastSnapshot.hookNanoseconds) / 1'000'000.0
+    ).c_str());
+
+    m_lastSnapshot = snapshot;
+}
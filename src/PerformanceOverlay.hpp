@@ -0,0 +1,34 @@
+#pragma once
+
+#include <Geode/cocos/base_nodes/CCNode.h>
+#include <Geode/cocos/label_nodes/CCLabelBMFont.h>
+#include <chrono>
+#include <cstdint>
+
+struct MetricsSnapshot {
+    uint64_t logLines = 0;
+    uint64_t logBytes = 0;
+    uint64_t suppressedLines = 0;
+    uint64_t droppedLines = 0;
+    uint64_t watcherEvents = 0;
+    uint64_t mainThreadCallbacks = 0;
+    uint64_t frames = 0;
+    uint64_t hookNanoseconds = 0;
+    std::chrono::steady_clock::time_point time;
+};
+
+class PerformanceOverlay : public cocos2d::CCNode {
+public:
+    static PerformanceOverlay* create();
+    static void setEnabled(bool enabled);
+
+    void refresh();
+protected:
+    bool init();
+    MetricsSnapshot takeSnapshot();
+
+    cocos2d::CCLabelBMFont* m_label = nullptr;
+    MetricsSnapshot m_lastSnapshot;
+
+    static PerformanceOverlay* s_instance;
+};
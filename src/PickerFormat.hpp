@@ -0,0 +1,48 @@
+#pragma once
+
+#include <Geode/utils/file.hpp>
+#include <Geode/utils/string.hpp>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <vector>
+
+/*
+    The text that goes between the game and the picker script, kept apart from the picker itself so the
+    benchmarks can build it without the rest of the mod.
+*/
+namespace sobriety::picker {
+
+    // Each filter becomes "description|ext ext", the script splits it back apart for whichever picker it finds.
+    static std::vector<std::string> generateExtensionStrings(std::vector<geode::utils::file::FilePickOptions::Filter> filters) {
+        std::vector<std::string> strings;
+
+        filters.push_back({"All Files", {"*.*"}});
+
+        for (const auto& filter : filters) {
+            std::string extStr = geode::utils::string::trim(filter.description);
+            extStr += "|";
+            for (const auto& extension : filter.files) {
+                extStr += geode::utils::string::trim(extension);
+                extStr += " ";
+            }
+            strings.push_back(geode::utils::string::trim(extStr));
+        }
+        return strings;
+    }
+
+    // The script writes one path per line, or -1 if the picker was cancelled, which comes back as nothing.
+    static std::optional<std::vector<std::filesystem::path>> parseSelection(const std::string& selection) {
+        if (selection == "-1") return std::nullopt;
+
+        auto parts = geode::utils::string::split(selection, "\n");
+        if (parts.empty()) return std::nullopt;
+
+        std::vector<std::filesystem::path> paths;
+        paths.reserve(parts.size());
+        for (const auto& path : parts) {
+            paths.push_back(path);
+        }
+        return paths;
+    }
+}
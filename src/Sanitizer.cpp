@@ -0,0 +1,336 @@
+#include "Sanitizer.hpp"
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <emmintrin.h>
+#include <immintrin.h>
+#include <windows.h>
+
+#if defined(_MSC_VER) && !defined(__clang__)
+    #define TARGET_AVX2
+#else
+    #define TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+#ifndef PF_AVX2_INSTRUCTIONS_AVAILABLE
+    #define PF_AVX2_INSTRUCTIONS_AVAILABLE 40
+#endif
+
+namespace {
+    constexpr size_t NONE = std::string_view::npos;
+
+    struct ScanResult {
+        bool control = false;
+        // the first byte that isn't ASCII, UTF-8 validation starts from here
+        size_t firstHigh = NONE;
+    };
+
+    bool isControl(uint8_t c) {
+        return (c < 0x20 && c != '\t' && c != '\n') || c == 0x7F;
+    }
+
+    void scanTail(const uint8_t* data, size_t start, size_t size, ScanResult& result) {
+        for (size_t i = start; i < size; i++) {
+            if (isControl(data[i])) {
+                result.control = true;
+                return;
+            }
+            if (data[i] >= 0x80 && result.firstHigh == NONE) result.firstHigh = i;
+        }
+    }
+
+    /*
+        A byte is a control character if it's below 0x20 but not a tab or newline, or it's DEL. The signed
+        compare also catches every byte from 0x80 up, those are masked back out with the sign bits.
+    */
+    ScanResult scanSSE2(const uint8_t* data, size_t size) {
+        ScanResult result;
+
+        const __m128i space = _mm_set1_epi8(0x20);
+        const __m128i tab = _mm_set1_epi8('\t');
+        const __m128i newline = _mm_set1_epi8('\n');
+        const __m128i del = _mm_set1_epi8(0x7F);
+
+        size_t i = 0;
+        for (; i + 16 <= size; i += 16) {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+
+            uint32_t high = _mm_movemask_epi8(v);
+            __m128i allowed = _mm_or_si128(_mm_cmpeq_epi8(v, tab), _mm_cmpeq_epi8(v, newline));
+            __m128i below = _mm_andnot_si128(allowed, _mm_cmplt_epi8(v, space));
+            uint32_t control = (_mm_movemask_epi8(_mm_or_si128(below, _mm_cmpeq_epi8(v, del))) & ~high);
+
+            if (control) {
+                result.control = true;
+                return result;
+            }
+            if (high && result.firstHigh == NONE) result.firstHigh = i + std::countr_zero(high);
+        }
+
+        scanTail(data, i, size, result);
+        return result;
+    }
+
+    // Scalar UTF-8 validation, for the SSE2 path. Only used on lines that actually have non-ASCII bytes.
+    bool validate(std::string_view input, size_t start);
+
+    bool checkSSE2(std::string_view input) {
+        auto result = scanSSE2(reinterpret_cast<const uint8_t*>(input.data()), input.size());
+        if (result.control) return false;
+        if (result.firstHigh == NONE) return true;
+        return validate(input, result.firstHigh);
+    }
+
+    /*
+        The AVX2 path checks control bytes and UTF-8 together in one pass, using the lookup method from
+        Keiser and Lemire's "Validating UTF-8 In Less Than One Instruction Per Byte". Each byte and the one before
+        it are classified through three 16 entry tables, and any error class left set in all three is invalid.
+        The 3rd and 4th bytes of longer sequences are checked separately, since the tables only see pairs.
+    */
+    constexpr uint8_t TOO_SHORT = 1 << 0;
+    constexpr uint8_t TOO_LONG = 1 << 1;
+    constexpr uint8_t OVERLONG_3 = 1 << 2;
+    constexpr uint8_t TOO_LARGE = 1 << 3;
+    constexpr uint8_t SURROGATE = 1 << 4;
+    constexpr uint8_t OVERLONG_2 = 1 << 5;
+    constexpr uint8_t TOO_LARGE_1000 = 1 << 6;
+    constexpr uint8_t OVERLONG_4 = 1 << 6;
+    constexpr uint8_t TWO_CONTS = 1 << 7;
+    constexpr uint8_t CARRY = TOO_SHORT | TOO_LONG | TWO_CONTS;
+
+    struct Utf8State {
+        __m256i error;
+        __m256i previous;
+        __m256i incomplete;
+    };
+
+    // the last N bytes of the previous block followed by this one
+    template <int N>
+    TARGET_AVX2 __m256i shiftIn(__m256i input, __m256i previous) {
+        return _mm256_alignr_epi8(input, _mm256_permute2x128_si256(previous, input, 0x21), 16 - N);
+    }
+
+    TARGET_AVX2 __m256i lookup(__m256i table, __m256i nibbles) {
+        return _mm256_shuffle_epi8(table, nibbles);
+    }
+
+    TARGET_AVX2 void checkBlock(__m256i input, Utf8State& state) {
+        const __m256i low = _mm256_set1_epi8(0x0F);
+
+        __m256i high = _mm256_cmpgt_epi8(_mm256_setzero_si256(), input);
+        __m256i allowed = _mm256_or_si256(_mm256_cmpeq_epi8(input, _mm256_set1_epi8('\t')), _mm256_cmpeq_epi8(input, _mm256_set1_epi8('\n')));
+        __m256i below = _mm256_andnot_si256(allowed, _mm256_cmpgt_epi8(_mm256_set1_epi8(0x20), input));
+        __m256i control = _mm256_andnot_si256(high, _mm256_or_si256(below, _mm256_cmpeq_epi8(input, _mm256_set1_epi8(0x7F))));
+        state.error = _mm256_or_si256(state.error, control);
+
+        if (_mm256_movemask_epi8(input) == 0) {
+            // an ASCII block can't finish a sequence the last block started
+            state.error = _mm256_or_si256(state.error, state.incomplete);
+            state.incomplete = _mm256_setzero_si256();
+            state.previous = input;
+            return;
+        }
+
+        const __m256i byte1HighTable = _mm256_setr_epi8(
+            TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG,
+            TWO_CONTS, TWO_CONTS, TWO_CONTS, TWO_CONTS,
+            TOO_SHORT | OVERLONG_2, TOO_SHORT, TOO_SHORT | OVERLONG_3 | SURROGATE, TOO_SHORT | TOO_LARGE | TOO_LARGE_1000 | OVERLONG_4,
+            TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG,
+            TWO_CONTS, TWO_CONTS, TWO_CONTS, TWO_CONTS,
+            TOO_SHORT | OVERLONG_2, TOO_SHORT, TOO_SHORT | OVERLONG_3 | SURROGATE, TOO_SHORT | TOO_LARGE | TOO_LARGE_1000 | OVERLONG_4
+        );
+        const __m256i byte1LowTable = _mm256_setr_epi8(
+            CARRY | OVERLONG_3 | OVERLONG_2 | OVERLONG_4, CARRY | OVERLONG_2, CARRY, CARRY,
+            CARRY | TOO_LARGE, CARRY | TOO_LARGE | TOO_LARGE_1000, CARRY | TOO_LARGE | TOO_LARGE_1000, CARRY | TOO_LARGE | TOO_LARGE_1000,
+            CARRY | TOO_LARGE | TOO_LARGE_1000, CARRY | TOO_LARGE | TOO_LARGE_1000, CARRY | TOO_LARGE | TOO_LARGE_1000, CARRY | TOO_LARGE | TOO_LARGE_1000,
+            CARRY | TOO_LARGE | TOO_LARGE_1000, CARRY | TOO_LARGE | TOO_LARGE_1000 | SURROGATE, CARRY | TOO_LARGE | TOO_LARGE_1000, CARRY | TOO_LARGE | TOO_LARGE_1000,
+            CARRY | OVERLONG_3 | OVERLONG_2 | OVERLONG_4, CARRY | OVERLONG_2, CARRY, CARRY,
+            CARRY | TOO_LARGE, CARRY | TOO_LARGE | TOO_LARGE_1000, CARRY | TOO_LARGE | TOO_LARGE_1000, CARRY | TOO_LARGE | TOO_LARGE_1000,
+            CARRY | TOO_LARGE | TOO_LARGE_1000, CARRY | TOO_LARGE | TOO_LARGE_1000, CARRY | TOO_LARGE | TOO_LARGE_1000, CARRY | TOO_LARGE | TOO_LARGE_1000,
+            CARRY | TOO_LARGE | TOO_LARGE_1000, CARRY | TOO_LARGE | TOO_LARGE_1000 | SURROGATE, CARRY | TOO_LARGE | TOO_LARGE_1000, CARRY | TOO_LARGE | TOO_LARGE_1000
+        );
+        const __m256i byte2HighTable = _mm256_setr_epi8(
+            TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT,
+            TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE_1000 | OVERLONG_4,
+            TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE,
+            TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE,
+            TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE,
+            TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT,
+            TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT,
+            TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE_1000 | OVERLONG_4,
+            TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE,
+            TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE,
+            TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE,
+            TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT
+        );
+
+        __m256i prev1 = shiftIn<1>(input, state.previous);
+        __m256i byte1High = lookup(byte1HighTable, _mm256_and_si256(_mm256_srli_epi16(prev1, 4), low));
+        __m256i byte1Low = lookup(byte1LowTable, _mm256_and_si256(prev1, low));
+        __m256i byte2High = lookup(byte2HighTable, _mm256_and_si256(_mm256_srli_epi16(input, 4), low));
+        __m256i special = _mm256_and_si256(_mm256_and_si256(byte1High, byte1Low), byte2High);
+
+        // a byte 2 or 3 after a 3 or 4 byte lead has to be a continuation, which the pair tables can't see
+        __m256i prev2 = shiftIn<2>(input, state.previous);
+        __m256i prev3 = shiftIn<3>(input, state.previous);
+        __m256i mustContinue = _mm256_or_si256(
+            _mm256_subs_epu8(prev2, _mm256_set1_epi8(static_cast<char>(0xE0 - 0x80))),
+            _mm256_subs_epu8(prev3, _mm256_set1_epi8(static_cast<char>(0xF0 - 0x80)))
+        );
+        mustContinue = _mm256_and_si256(mustContinue, _mm256_set1_epi8(static_cast<char>(0x80)));
+        state.error = _mm256_or_si256(state.error, _mm256_xor_si256(mustContinue, special));
+
+        // C2 80 to C2 9F, the C1 controls
+        __m256i c1 = _mm256_and_si256(
+            _mm256_cmpeq_epi8(prev1, _mm256_set1_epi8(static_cast<char>(0xC2))),
+            _mm256_cmpeq_epi8(_mm256_and_si256(input, _mm256_set1_epi8(static_cast<char>(0xE0))), _mm256_set1_epi8(static_cast<char>(0x80)))
+        );
+        state.error = _mm256_or_si256(state.error, c1);
+
+        // leads too close to the end of the block to have finished, only an error if the next block doesn't continue them
+        const __m256i maxValues = _mm256_setr_epi8(
+            -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+            -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+            static_cast<char>(0xF0 - 1), static_cast<char>(0xE0 - 1), static_cast<char>(0xC0 - 1)
+        );
+        state.incomplete = _mm256_subs_epu8(input, maxValues);
+        state.previous = input;
+    }
+
+    TARGET_AVX2 bool checkAVX2(std::string_view input) {
+        auto data = reinterpret_cast<const uint8_t*>(input.data());
+        Utf8State state = { _mm256_setzero_si256(), _mm256_setzero_si256(), _mm256_setzero_si256() };
+
+        size_t i = 0;
+        for (; i + 32 <= input.size(); i += 32) {
+            checkBlock(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i)), state);
+        }
+
+        // the rest is padded with spaces, which also flushes out a sequence cut off at the end
+        alignas(32) uint8_t tail[32];
+        std::memset(tail, ' ', sizeof(tail));
+        std::memcpy(tail, data + i, input.size() - i);
+        checkBlock(_mm256_load_si256(reinterpret_cast<const __m256i*>(tail)), state);
+
+        return _mm256_testz_si256(state.error, state.error);
+    }
+
+    /*
+        Returns the length of the UTF-8 sequence at i, or 0 if it isn't valid. Overlong forms, surrogates and
+        anything past U+10FFFF are all invalid, same as what a terminal would choke on.
+    */
+    size_t decode(const uint8_t* data, size_t size, size_t i, uint32_t& codepoint) {
+        uint8_t lead = data[i];
+        size_t length;
+        uint32_t min;
+
+        if (lead < 0x80) {
+            codepoint = lead;
+            return 1;
+        }
+        else if ((lead & 0xE0) == 0xC0) { length = 2; min = 0x80; codepoint = lead & 0x1F; }
+        else if ((lead & 0xF0) == 0xE0) { length = 3; min = 0x800; codepoint = lead & 0x0F; }
+        else if ((lead & 0xF8) == 0xF0) { length = 4; min = 0x10000; codepoint = lead & 0x07; }
+        else return 0;
+
+        if (i + length > size) return 0;
+        for (size_t j = 1; j < length; j++) {
+            if ((data[i + j] & 0xC0) != 0x80) return 0;
+            codepoint = (codepoint << 6) | (data[i + j] & 0x3F);
+        }
+
+        if (codepoint < min || codepoint > 0x10FFFF) return 0;
+        if (codepoint >= 0xD800 && codepoint <= 0xDFFF) return 0;
+        return length;
+    }
+
+    // C1 controls are valid UTF-8, but some terminals still act on them, U+009B is a CSI.
+    bool isC1(uint32_t codepoint) {
+        return codepoint >= 0x80 && codepoint <= 0x9F;
+    }
+
+    bool validate(std::string_view input, size_t start) {
+        auto data = reinterpret_cast<const uint8_t*>(input.data());
+        for (size_t i = start; i < input.size();) {
+            if (data[i] < 0x80) {
+                i++;
+                continue;
+            }
+            uint32_t codepoint;
+            auto length = decode(data, input.size(), i, codepoint);
+            if (length == 0 || isC1(codepoint)) return false;
+            i += length;
+        }
+        return true;
+    }
+
+    // ESC [ then parameters then m, the only sequence let through since it only changes colors.
+    size_t sgrLength(std::string_view input, size_t i) {
+        if (i + 2 >= input.size() || input[i + 1] != '[') return 0;
+        for (size_t j = i + 2; j < input.size() && j < i + 32; j++) {
+            char c = input[j];
+            if (c == 'm') return j - i + 1;
+            if ((c < '0' || c > '9') && c != ';') return 0;
+        }
+        return 0;
+    }
+}
+
+bool sobriety::sanitizer::isClean(std::string_view input) {
+    static const bool avx2 = IsProcessorFeaturePresent(PF_AVX2_INSTRUCTIONS_AVAILABLE);
+    return avx2 ? checkAVX2(input) : checkSSE2(input);
+}
+
+bool sobriety::sanitizer::isCleanSSE2(std::string_view input) {
+    return checkSSE2(input);
+}
+
+bool sobriety::sanitizer::isCleanAVX2(std::string_view input) {
+    return checkAVX2(input);
+}
+
+std::string sobriety::sanitizer::sanitize(std::string_view input) {
+    static constexpr char HEX[] = "0123456789abcdef";
+
+    auto data = reinterpret_cast<const uint8_t*>(input.data());
+    std::string output;
+    output.reserve(input.size() + 16);
+
+    for (size_t i = 0; i < input.size();) {
+        uint8_t c = data[i];
+
+        if (c == 0x1B) {
+            if (auto length = sgrLength(input, i)) {
+                output.append(input.substr(i, length));
+                i += length;
+                continue;
+            }
+        }
+
+        if (isControl(c)) {
+            output += '^';
+            output += c == 0x7F ? '?' : static_cast<char>(c + 0x40);
+            i++;
+            continue;
+        }
+
+        uint32_t codepoint;
+        auto length = decode(data, input.size(), i, codepoint);
+        if (length == 0) {
+            output += "\xEF\xBF\xBD";
+            i++;
+        }
+        else if (isC1(codepoint)) {
+            output += "\\u00";
+            output += HEX[codepoint >> 4];
+            output += HEX[codepoint & 0xF];
+            i += length;
+        }
+        else {
+            output.append(input.substr(i, length));
+            i += length;
+        }
+    }
+
+    return output;
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+/*
+    Log messages come from any mod and go straight into the terminal's escape sequence stream, so a stray ESC
+    or a broken UTF-8 sequence can reset the palette or wedge the terminal. Nearly every line is fine, so
+    checking is one vectorized pass, and only lines that fail it are copied and fixed.
+
+    Tabs, newlines and SGR color sequences (ESC [ ... m) are kept. Other control characters become caret
+    notation (^[), C1 controls become \u escapes, and invalid UTF-8 becomes U+FFFD.
+*/
+namespace sobriety::sanitizer {
+    bool isClean(std::string_view input);
+    std::string sanitize(std::string_view input);
+
+    // The two scans isClean picks between, for the benchmarks to check against each other. AVX2 needs the CPU to have it.
+    bool isCleanSSE2(std::string_view input);
+    bool isCleanAVX2(std::string_view input);
+}
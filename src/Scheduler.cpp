@@ -1,5 +1,11 @@
 #include <Geode/Geode.hpp>
 #include "Scheduler.hpp"
+#include "Config.hpp"
+#include "FrameProfiler.hpp"
+#include "Mailbox.hpp"
+#include "Metrics.hpp"
+#include "StallDetector.hpp"
+#include "Trace.hpp"
 
 using namespace geode::prelude;
 
@@ -24,9 +30,15 @@ void Scheduler::unschedule(const std::string& id) {
 }
 
 void Scheduler::update(float dt) {
+    Metrics::get()->add(Metrics::get()->frames);
+    StallDetector::get()->tick();
+    FrameProfiler::get()->tick();
+    Mailbox::get()->drain(std::chrono::microseconds(Config::get()->getSettings()->mainThreadBudget));
+
     for (auto& [k, v] : m_scheduledMethods) {
         v.elapsedTime += dt * 1000;
         if (v.elapsedTime >= v.interval) {
+            TraceSpan span("scheduled task", "scheduler", k);
             if (v.method) v.method();
             v.elapsedTime -= v.interval;
         }
@@ -0,0 +1,145 @@
+#include <Geode/Geode.hpp>
+#include <algorithm>
+#include "SessionCollector.hpp"
+#include "Config.hpp"
+#include "ThreadRegistry.hpp"
+
+using namespace geode::prelude;
+
+// How often a running instance renews its lease, and how long until a session without one is considered dead.
+static constexpr auto LEASE_INTERVAL = std::chrono::seconds(10);
+static constexpr auto LEASE_TIMEOUT = std::chrono::minutes(2);
+
+// Dead sessions are kept for a while so crash logs can still be grabbed, unless they take up too much space.
+static constexpr auto MAX_AGE = std::chrono::hours(1);
+static constexpr uintmax_t MAX_TOTAL_SIZE = 64 * 1024 * 1024;
+
+SessionCollector* SessionCollector::get() {
+    static SessionCollector instance;
+    return &instance;
+}
+
+/*
+    Every launch makes a new /tmp/GeometryDash-<ms>/ directory, which never gets removed. On tmpfs that's RAM.
+    Each running instance keeps a lease file fresh in its own directory, so any directory with an expired
+    lease belongs to an instance that is gone, and can be cleaned up by whichever instance starts next.
+*/
+void SessionCollector::setup() {
+    ThreadRegistry::get()->spawn({ .name = "session collector", .priority = ThreadPriority::Low }, [this](std::stop_token token) {
+        renewLease();
+        collect();
+
+        while (!ThreadRegistry::sleepFor(token, LEASE_INTERVAL)) {
+            renewLease();
+        }
+    });
+}
+
+void SessionCollector::renewLease() {
+    auto now = std::chrono::system_clock::now();
+    auto nowMs = std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()).count();
+
+    auto res = utils::file::writeString(Config::get()->getUniquePath() / "session.lease", std::to_string(nowMs));
+    if (!res) log::error("Failed to renew session lease");
+}
+
+void SessionCollector::collect() {
+    std::error_code ec;
+    auto ownPath = std::filesystem::path(Config::get()->getUniquePath()).parent_path();
+    auto now = std::chrono::system_clock::now();
+
+    std::vector<StaleSession> sessions;
+
+    for (const auto& entry : std::filesystem::directory_iterator("/tmp", ec)) {
+        if (!entry.is_directory(ec)) continue;
+
+        auto name = utils::string::pathToString(entry.path().filename());
+        if (!name.starts_with("GeometryDash-")) continue;
+
+        auto suffix = std::string_view(name).substr(std::string_view("GeometryDash-").size());
+        if (suffix.empty() || !std::ranges::all_of(suffix, [](char c) { return std::isdigit(c); })) continue;
+
+        if (entry.path() == ownPath) continue;
+
+        auto lastActive = getLastActive(entry.path());
+        if (now - lastActive < LEASE_TIMEOUT) continue;
+
+        sessions.push_back({entry.path(), lastActive, getDirectorySize(entry.path())});
+    }
+
+    if (sessions.empty()) return;
+
+    std::ranges::sort(sessions, [](const StaleSession& a, const StaleSession& b) {
+        return a.lastActive > b.lastActive;
+    });
+
+    uintmax_t keptSize = 0;
+    uintmax_t reclaimed = 0;
+    size_t removed = 0;
+
+    // newest first, so the most recent sessions are the ones that stay within the size budget
+    for (const auto& session : sessions) {
+        if (now - session.lastActive < MAX_AGE && keptSize + session.size <= MAX_TOTAL_SIZE) {
+            keptSize += session.size;
+            continue;
+        }
+
+        std::filesystem::remove_all(session.path, ec);
+        if (ec) {
+            log::warn("Failed to remove stale session directory {}: {}", session.path, ec.message());
+            continue;
+        }
+
+        reclaimed += session.size;
+        removed++;
+    }
+
+    if (removed > 0) {
+        log::info("Removed {} stale session directories, reclaimed {} bytes", removed, reclaimed);
+    }
+}
+
+/*
+    Sessions from older versions have no lease, so we fall back to the newest file in the directory.
+    While an instance with a console is alive, its heartbeat file is rewritten constantly anyway.
+*/
+std::chrono::system_clock::time_point SessionCollector::getLastActive(const std::filesystem::path& directory) {
+    auto strRes = utils::file::readString(directory / "session.lease");
+    if (strRes) {
+        auto str = strRes.unwrap();
+        utils::string::trimIP(str);
+
+        if (auto millisRes = numFromString<long long>(str)) {
+            return std::chrono::system_clock::time_point(std::chrono::milliseconds(millisRes.unwrap()));
+        }
+    }
+
+    std::error_code ec;
+    auto newest = std::filesystem::file_time_type::min();
+
+    for (const auto& entry : std::filesystem::directory_iterator(directory, ec)) {
+        auto time = entry.last_write_time(ec);
+        if (!ec && time > newest) newest = time;
+    }
+
+    if (newest == std::filesystem::file_time_type::min()) {
+        newest = std::filesystem::last_write_time(directory, ec);
+        if (ec) return std::chrono::system_clock::now();
+    }
+
+    return std::chrono::clock_cast<std::chrono::system_clock>(newest);
+}
+
+uintmax_t SessionCollector::getDirectorySize(const std::filesystem::path& directory) {
+    std::error_code ec;
+    uintmax_t size = 0;
+
+    for (const auto& entry : std::filesystem::recursive_directory_iterator(directory, ec)) {
+        if (entry.is_regular_file(ec)) {
+            auto fileSize = entry.file_size(ec);
+            if (!ec) size += fileSize;
+        }
+    }
+
+    return size;
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+
+struct StaleSession {
+    std::filesystem::path path;
+    std::chrono::system_clock::time_point lastActive;
+    uintmax_t size = 0;
+};
+
+class SessionCollector {
+public:
+    static SessionCollector* get();
+
+    void setup();
+    void renewLease();
+    void collect();
+
+private:
+    std::chrono::system_clock::time_point getLastActive(const std::filesystem::path& directory);
+    uintmax_t getDirectorySize(const std::filesystem::path& directory);
+};
@@ -0,0 +1,238 @@
+#include <Geode/Geode.hpp>
+#include "SpawnBroker.hpp"
+#include "Config.hpp"
+#include "FileWatcher.hpp"
+#include "LatencyTracker.hpp"
+#include "Trace.hpp"
+#include "Utils.hpp"
+
+using namespace geode::prelude;
+
+SpawnBroker* SpawnBroker::get() {
+    static SpawnBroker instance;
+    return &instance;
+}
+
+/*
+    Every CreateProcessA call goes through all of wine's process startup before bash even runs, which is slow.
+    Instead, we pay for that once by starting a broker that lives on the linux side for the whole session. 
+    Requests are appended to a queue file the broker follows, and exit codes come back through a status file.
+*/
+void SpawnBroker::setup() {
+    sobriety::utils::createTempDir();
+
+    auto queuePath = Config::get()->getUniquePath() / "broker.queue";
+    auto queueRes = utils::file::writeString(queuePath, "");
+    if (!queueRes) return log::error("Failed to create broker queue file");
+
+    auto statusRes = utils::file::writeString(Config::get()->getUniquePath() / "broker.status", "");
+    if (!statusRes) return log::error("Failed to create broker status file");
+
+    setupScript();
+
+    auto watcher = FileWatcher::getForDirectory(Config::get()->getUniquePath());
+    watcher->watchContents("broker.status", [this](const std::string& str) {
+        notifyStatusChange(str);
+    });
+
+    m_queueAppender.store(std::make_shared<FileAppender>(queuePath));
+
+    // published last, spawn only looks at the appender once this is set
+    bool active = sobriety::utils::runCommand(fmt::format("{}/broker.exe {}", 
+        Config::get()->getUniquePath(), 
+        Config::get()->getUniquePath()
+    ));
+    m_active.store(active);
+
+    if (!active) log::warn("Failed to start spawn broker, falling back to wine process creation");
+}
+
+void SpawnBroker::setupScript() {
+    static std::string script = 
+R"script(#!/bin/bash
+
+UNIQUE_PATH="${1}"
+
+QUEUE_FILE="$UNIQUE_PATH/broker.queue"
+STATUS_FILE="$UNIQUE_PATH/broker.status"
+EXIT_FILE="$UNIQUE_PATH/broker.exit"
+LEASE_FILE="$UNIQUE_PATH/session.lease"
+
+launch() {
+    local ID="$1"
+    local CWD="$2"
+    local ENV_LIST=()
+    [ -n "$3" ] && IFS=$'\x1e' read -r -a ENV_LIST <<< "$3"
+    shift 3
+
+    # helper scripts are named .exe so wine can run them, they aren't executable
+    case "$1" in
+        *.exe) set -- bash "$@" ;;
+    esac
+
+    (
+        [ -n "$CWD" ] && cd "$CWD"
+        env BROKER_PID="$$" "${ENV_LIST[@]}" "$@" < /dev/null
+        echo "$ID $?" >> "$STATUS_FILE"
+    ) &
+}
+
+# the game renews its lease every 10 seconds, a lease this old means it's gone, crashed or not
+game_alive() {
+    local LEASE
+    LEASE="$(cat "$LEASE_FILE" 2>/dev/null)"
+    [ -z "$LEASE" ] && return 0
+    (( $(date +%s%3N) - LEASE < 30000 ))
+}
+
+exec {QUEUE_FD}< <(tail -n +1 -F "$QUEUE_FILE" 2>/dev/null)
+TAIL_PID=$!
+
+# nothing calls shutdown after a crash, so this asks the loop below to stop the same way shutdown does
+(
+    while kill -0 "$$" 2>/dev/null && game_alive; do sleep 5; done
+    if kill -0 "$$" 2>/dev/null; then
+        : > "$EXIT_FILE"
+        echo >> "$QUEUE_FILE"
+    fi
+) &
+WATCHDOG_PID=$!
+
+while IFS=$'\x1f' read -r -u "$QUEUE_FD" -a REQUEST; do
+    [ -f "$EXIT_FILE" ] && break
+    [ "${#REQUEST[@]}" -lt 4 ] && continue
+    launch "${REQUEST[@]}"
+done
+
+kill "$TAIL_PID" "$WATCHDOG_PID" 2>/dev/null
+rm -f "$EXIT_FILE"
+
+)script";
+
+    auto path = Config::get()->getUniquePath() / "broker.exe";
+    auto res = utils::file::writeString(path, script);
+    if (!res) return log::error("Failed to create broker script");
+}
+
+// Fields are split by the ASCII unit separator, env entries by the record separator, and requests by newlines.
+static std::string sanitizeField(std::string_view field) {
+    std::string ret{field};
+    for (auto& c : ret) {
+        if (c == '\n' || c == '\r' || c == '\x1f' || c == '\x1e') c = ' ';
+    }
+    return ret;
+}
+
+std::string SpawnBroker::buildRequest(unsigned int id, const SpawnRequest& request) {
+    std::string line = fmt::format("{}\x1f{}\x1f", id, sanitizeField(request.cwd));
+
+    for (size_t i = 0; i < request.env.size(); i++) {
+        if (i != 0) line += '\x1e';
+        line += sanitizeField(request.env[i]);
+    }
+
+    for (const auto& arg : request.args) {
+        line += '\x1f';
+        line += sanitizeField(arg);
+    }
+
+    line += '\n';
+    return line;
+}
+
+/*
+    Quoted the way CommandLineToArgvW splits it back apart: a quote inside an argument is escaped with a
+    backslash, and backslashes only need doubling when a quote follows them.
+*/
+std::string SpawnBroker::buildCommandLine(const SpawnRequest& request) {
+    std::string command;
+    for (const auto& arg : request.args) {
+        if (!command.empty()) command += " ";
+        command += "\"";
+
+        size_t backslashes = 0;
+        for (auto c : arg) {
+            if (c == '\\') {
+                backslashes++;
+                continue;
+            }
+            if (c == '"') command.append(backslashes * 2 + 1, '\\');
+            else command.append(backslashes, '\\');
+            backslashes = 0;
+            command += c;
+        }
+        // the closing quote follows them too
+        command.append(backslashes * 2, '\\');
+
+        command += "\"";
+    }
+    return command;
+}
+
+void SpawnBroker::spawn(SpawnRequest&& request, std::function<void(int)>&& onExit) {
+    if (request.args.empty()) return;
+
+    TraceSpan span("spawn", "process", request.args[0]);
+    auto start = std::chrono::steady_clock::now();
+
+    // spawn latency ends once the request is out of our hands, whatever the process does after is its own time
+    auto queueAppender = m_queueAppender.load();
+    if (!m_active || !queueAppender) {
+        if (sobriety::utils::runCommand(buildCommandLine(request))) LatencyTracker::get()->record(LatencyStage::Spawn, start);
+        return;
+    }
+
+    std::string line;
+    {
+        std::lock_guard lock(m_mutex);
+        auto id = m_nextId++;
+        if (onExit) m_callbacks[id] = std::move(onExit);
+        line = buildRequest(id, request);
+    }
+
+    queueAppender->append(line);
+    LatencyTracker::get()->record(LatencyStage::Spawn, start);
+}
+
+void SpawnBroker::notifyStatusChange(const std::string& str) {
+    if (str.size() <= m_statusOffset) return;
+
+    auto end = str.find_last_of('\n');
+    if (end == std::string::npos || end < m_statusOffset) return;
+
+    auto lines = utils::string::split(str.substr(m_statusOffset, end - m_statusOffset), "\n");
+    m_statusOffset = end + 1;
+
+    for (const auto& line : lines) {
+        auto parts = utils::string::split(line, " ");
+        if (parts.size() != 2) continue;
+
+        auto idRes = numFromString<unsigned int>(parts[0]);
+        auto statusRes = numFromString<int>(parts[1]);
+        if (!idRes || !statusRes) continue;
+
+        auto status = statusRes.unwrap();
+        if (status != 0) log::debug("Spawned process {} exited with status {}", idRes.unwrap(), status);
+
+        std::function<void(int)> callback;
+        {
+            std::lock_guard lock(m_mutex);
+            auto iter = m_callbacks.find(idRes.unwrap());
+            if (iter == m_callbacks.end()) continue;
+            callback = std::move(iter->second);
+            m_callbacks.erase(iter);
+        }
+        if (callback) callback(status);
+    }
+}
+
+void SpawnBroker::shutdown() {
+    if (!m_active.exchange(false)) return;
+
+    auto exitPath = Config::get()->getUniquePath() / "broker.exit";
+    auto res = utils::file::writeString(exitPath, "");
+    if (!res) return log::error("Failed to create broker exit file");
+
+    // wakes the broker up so it sees the exit file
+    if (auto queueAppender = m_queueAppender.load()) queueAppender->append("\n");
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "FileAppender.hpp"
+
+struct SpawnRequest {
+    std::vector<std::string> args;
+    std::vector<std::string> env;
+    std::string cwd;
+};
+
+class SpawnBroker {
+public:
+    static SpawnBroker* get();
+
+    void setup();
+    void setupScript();
+    void spawn(SpawnRequest&& request, std::function<void(int)>&& onExit = nullptr);
+    void notifyStatusChange(const std::string& str);
+    void shutdown();
+
+private:
+    std::string buildRequest(unsigned int id, const SpawnRequest& request);
+    std::string buildCommandLine(const SpawnRequest& request);
+
+    // set from the deferred startup thread, read from wherever spawn is called
+    std::atomic<bool> m_active = false;
+    unsigned int m_nextId = 0;
+    size_t m_statusOffset = 0;
+    std::atomic<std::shared_ptr<FileAppender>> m_queueAppender;
+    std::unordered_map<unsigned int, std::function<void(int)>> m_callbacks;
+    std::mutex m_mutex;
+};
@@ -0,0 +1,217 @@
+#include <Geode/Geode.hpp>
+#include <array>
+#include <psapi.h>
+#include "StallDetector.hpp"
+#include "Config.hpp"
+#include "ThreadRegistry.hpp"
+
+using namespace geode::prelude;
+
+static constexpr size_t MAX_FRAMES = 32;
+
+StallDetector* StallDetector::get() {
+    static StallDetector instance;
+    return &instance;
+}
+
+long long StallDetector::now() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void StallDetector::tick() {
+    m_lastTick.store(now(), std::memory_order_relaxed);
+}
+
+/*
+    Must be called from the main thread, as that's the thread we grab a handle to.
+    The watchdog only starts judging once the Scheduler has ticked at least once, since loading isn't a stall.
+*/
+void StallDetector::setup() {
+    m_mainThread = OpenThread(
+        THREAD_SUSPEND_RESUME | THREAD_GET_CONTEXT | THREAD_QUERY_INFORMATION,
+        FALSE,
+        GetCurrentThreadId()
+    );
+
+    if (!m_mainThread) return log::error("Failed to open main thread for stall detection: {}", GetLastError());
+
+    // the whole range reserved for the main thread's stack, straight from its TEB, so the walk never reads past it
+    ULONG_PTR stackLow, stackHigh;
+    GetCurrentThreadStackLimits(&stackLow, &stackHigh);
+    m_stackLow = stackLow;
+    m_stackHigh = stackHigh;
+
+    // normal priority, since it has to get a look in while the game is busy
+    ThreadRegistry::get()->spawn({ .name = "stall watchdog", .priority = ThreadPriority::Normal }, [this](std::stop_token token) {
+        bool stalled = false;
+        long long stallStart = 0;
+
+        while (!ThreadRegistry::sleepFor(token, std::chrono::milliseconds(25))) {
+            auto budget = Config::get()->getStallBudget();
+            auto lastTick = m_lastTick.load(std::memory_order_relaxed);
+            if (budget <= 0 || lastTick == 0) continue;
+
+            auto elapsed = now() - lastTick;
+
+            if (!stalled && elapsed > budget) {
+                stalled = true;
+                stallStart = lastTick;
+
+                auto frames = captureMainThreadStack();
+
+                std::string trace;
+                for (auto address : frames) {
+                    trace += fmt::format("\n  - {}", symbolize(address));
+                }
+
+                log::warn("Main thread has not ticked for {}ms{}", elapsed, trace.empty() ? "" : ", it is currently at:" + trace);
+            }
+            else if (stalled && lastTick != stallStart) {
+                stalled = false;
+                log::warn("Main thread stalled for {}ms", lastTick - stallStart);
+            }
+        }
+    });
+}
+
+namespace {
+    struct ModuleRange {
+        uintptr_t base;
+        uintptr_t end;
+        const RUNTIME_FUNCTION* functions;
+        size_t functionCount;
+    };
+
+    // Every loaded module and its unwind table, taken before suspending so the walk never has to ask the loader.
+    std::vector<ModuleRange> snapshotModules() {
+        std::vector<HMODULE> handles(1024);
+        DWORD needed = 0;
+        if (!EnumProcessModules(GetCurrentProcess(), handles.data(), handles.size() * sizeof(HMODULE), &needed)) return {};
+        handles.resize(std::min<size_t>(handles.size(), needed / sizeof(HMODULE)));
+
+        std::vector<ModuleRange> modules;
+        modules.reserve(handles.size());
+        for (auto handle : handles) {
+            auto base = reinterpret_cast<uintptr_t>(handle);
+            auto dos = reinterpret_cast<const IMAGE_DOS_HEADER*>(base);
+            auto nt = reinterpret_cast<const IMAGE_NT_HEADERS64*>(base + dos->e_lfanew);
+            const auto& directory = nt->OptionalHeader.DataDirectory[IMAGE_DIRECTORY_ENTRY_EXCEPTION];
+
+            modules.push_back({
+                base,
+                base + nt->OptionalHeader.SizeOfImage,
+                reinterpret_cast<const RUNTIME_FUNCTION*>(base + directory.VirtualAddress),
+                directory.VirtualAddress ? directory.Size / sizeof(RUNTIME_FUNCTION) : 0
+            });
+        }
+        return modules;
+    }
+
+    const ModuleRange* findModule(const ModuleRange* modules, size_t count, uintptr_t address) {
+        for (size_t i = 0; i < count; i++) {
+            if (address >= modules[i].base && address < modules[i].end) return &modules[i];
+        }
+        return nullptr;
+    }
+
+    // The same binary search RtlLookupFunctionEntry does, without the loader lock it takes to find the table.
+    const RUNTIME_FUNCTION* findFunction(const ModuleRange& module, uintptr_t address) {
+        auto rva = static_cast<DWORD>(address - module.base);
+        size_t low = 0;
+        size_t high = module.functionCount;
+
+        while (low < high) {
+            auto mid = low + (high - low) / 2;
+            const auto& function = module.functions[mid];
+
+            if (rva < function.BeginAddress) high = mid;
+            else if (rva >= function.EndAddress) low = mid + 1;
+            // an odd UnwindData points at the entry that really describes this range
+            else if (function.UnwindData & 1) return reinterpret_cast<const RUNTIME_FUNCTION*>(module.base + function.UnwindData - 1);
+            else return &function;
+        }
+        return nullptr;
+    }
+
+    /*
+        Runs with the main thread suspended, so it only reads memory: no allocation, no locks, nothing from the
+        loader. The stack pointer has to stay aligned and inside the stack, and the instruction pointer inside a
+        module, or the walk is lost and stops there. Anything that still faults, like a module unloaded since the
+        snapshot, ends the walk instead of the game.
+    */
+    size_t walkStack(CONTEXT& context, uintptr_t stackLow, uintptr_t stackHigh, const ModuleRange* modules, size_t moduleCount, uintptr_t* frames, size_t maxFrames) {
+        size_t count = 0;
+
+        __try {
+            while (count < maxFrames && context.Rip) {
+                frames[count++] = context.Rip;
+
+                if (context.Rsp < stackLow || context.Rsp >= stackHigh || context.Rsp % sizeof(DWORD64) != 0) break;
+
+                auto module = findModule(modules, moduleCount, context.Rip);
+                if (!module) break;
+
+                auto function = findFunction(*module, context.Rip);
+                if (!function) {
+                    // leaf functions have no unwind info, their return address is right at the stack pointer
+                    context.Rip = *reinterpret_cast<const DWORD64*>(context.Rsp);
+                    context.Rsp += sizeof(DWORD64);
+                    continue;
+                }
+
+                PVOID handlerData;
+                DWORD64 establisherFrame;
+                RtlVirtualUnwind(
+                    UNW_FLAG_NHANDLER, module->base, context.Rip, const_cast<PRUNTIME_FUNCTION>(function),
+                    &context, &handlerData, &establisherFrame, nullptr
+                );
+            }
+        }
+        __except (EXCEPTION_EXECUTE_HANDLER) {}
+
+        return count;
+    }
+}
+
+/*
+    Nothing here may allocate or log while the main thread is suspended, as it could be holding the heap
+    or log lock. Only raw addresses are collected, they get symbolized after it's been resumed.
+*/
+std::vector<uintptr_t> StallDetector::captureMainThreadStack() {
+    std::array<uintptr_t, MAX_FRAMES> frames{};
+    size_t count = 0;
+
+    if (m_stackHigh == 0) return {};
+    auto modules = snapshotModules();
+
+    if (SuspendThread(m_mainThread) == static_cast<DWORD>(-1)) return {};
+
+    CONTEXT context{};
+    context.ContextFlags = CONTEXT_FULL;
+
+    if (GetThreadContext(m_mainThread, &context)) {
+        count = walkStack(context, m_stackLow, m_stackHigh, modules.data(), modules.size(), frames.data(), frames.size());
+    }
+
+    ResumeThread(m_mainThread);
+
+    return {frames.begin(), frames.begin() + count};
+}
+
+std::string StallDetector::symbolize(uintptr_t address) {
+    HMODULE module = nullptr;
+    if (!GetModuleHandleExW(
+        GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS | GET_MODULE_HANDLE_EX_FLAG_UNCHANGED_REFCOUNT,
+        reinterpret_cast<LPCWSTR>(address),
+        &module
+    )) {
+        return fmt::format("0x{:x}", address);
+    }
+
+    wchar_t path[MAX_PATH];
+    auto length = GetModuleFileNameW(module, path, MAX_PATH);
+    if (length == 0) return fmt::format("0x{:x}", address);
+
+    auto name = utils::string::pathToString(std::filesystem::path(std::wstring(path, length)).filename());
+    return fmt::format("{}+0x{:x}", name, address - reinterpret_cast<uintptr_t>(module));
+}
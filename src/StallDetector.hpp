@@ -0,0 +1,25 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class StallDetector {
+public:
+    static StallDetector* get();
+
+    void setup();
+    void tick();
+
+private:
+    std::vector<uintptr_t> captureMainThreadStack();
+    std::string symbolize(uintptr_t address);
+    static long long now();
+
+    HANDLE m_mainThread = nullptr;
+    uintptr_t m_stackLow = 0;
+    uintptr_t m_stackHigh = 0;
+    std::atomic<long long> m_lastTick = 0;
+};
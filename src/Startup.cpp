@@ -0,0 +1,39 @@
+#include <Geode/Geode.hpp>
+#include "Startup.hpp"
+
+using namespace geode::prelude;
+
+Startup* Startup::get() {
+    static Startup instance;
+    return &instance;
+}
+
+void Startup::measure(const std::string& name, std::function<void()>&& method, bool deferred) {
+    auto start = std::chrono::steady_clock::now();
+    if (method) method();
+    auto duration = std::chrono::steady_clock::now() - start;
+
+    std::lock_guard lock(m_mutex);
+    m_phases.push_back({name, duration, deferred});
+}
+
+/*
+    Only the non deferred phases hold up the game's launch, the rest run in the background,
+    so they are reported separately to make our real share of the startup time obvious.
+*/
+void Startup::report() {
+    std::lock_guard lock(m_mutex);
+
+    std::chrono::duration<double, std::milli> blocking{};
+    std::chrono::duration<double, std::milli> deferred{};
+
+    for (const auto& phase : m_phases) {
+        std::chrono::duration<double, std::milli> ms = phase.duration;
+        log::debug("Startup phase \"{}\" took {:.3f}ms{}", phase.name, ms.count(), phase.deferred ? " (deferred)" : "");
+
+        if (phase.deferred) deferred += ms;
+        else blocking += ms;
+    }
+
+    log::info("Startup took {:.3f}ms on the main thread and {:.3f}ms in the background", blocking.count(), deferred.count());
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+struct StartupPhase {
+    std::string name;
+    std::chrono::steady_clock::duration duration;
+    bool deferred;
+};
+
+class Startup {
+public:
+    static Startup* get();
+
+    void measure(const std::string& name, std::function<void()>&& method, bool deferred = false);
+    void report();
+
+private:
+    std::vector<StartupPhase> m_phases;
+    std::mutex m_mutex;
+};
@@ -0,0 +1,119 @@
+#include <Geode/Geode.hpp>
+#include "ThreadRegistry.hpp"
+#include "Config.hpp"
+
+using namespace geode::prelude;
+
+ThreadRegistry* ThreadRegistry::get() {
+    static ThreadRegistry instance;
+    return &instance;
+}
+
+void ThreadRegistry::applyOptions(const ThreadOptions& options) {
+    // wine passes this on to the unix thread, so it shows up in /proc/<pid>/task/*/comm and in debuggers
+    SetThreadDescription(GetCurrentThread(), utils::string::utf8ToWide(options.name).c_str());
+
+    int priority = THREAD_PRIORITY_NORMAL;
+    switch (options.priority) {
+        case ThreadPriority::Normal: priority = THREAD_PRIORITY_NORMAL; break;
+        case ThreadPriority::Background: priority = THREAD_PRIORITY_BELOW_NORMAL; break;
+        case ThreadPriority::Low: priority = THREAD_PRIORITY_LOWEST; break;
+        case ThreadPriority::Idle: priority = THREAD_PRIORITY_IDLE; break;
+    }
+    SetThreadPriority(GetCurrentThread(), priority);
+
+    auto affinity = Config::get()->getHelperAffinity();
+    if (affinity != 0 && options.useHelperAffinity && options.priority != ThreadPriority::Normal) {
+        DWORD_PTR processMask = 0;
+        DWORD_PTR systemMask = 0;
+        GetProcessAffinityMask(GetCurrentProcess(), &processMask, &systemMask);
+
+        // a mask with none of our CPUs in it would leave the thread unable to run at all
+        auto mask = static_cast<DWORD_PTR>(affinity) & processMask;
+        if (mask != 0) SetThreadAffinityMask(GetCurrentThread(), mask);
+    }
+}
+
+void ThreadRegistry::spawn(ThreadOptions&& options, std::function<void(std::stop_token)>&& body) {
+    std::lock_guard lock(m_mutex);
+    if (m_stopping) return;
+
+    reapFinished();
+
+    auto managed = std::make_shared<ManagedThread>();
+    managed->name = options.name;
+
+    auto token = managed->stopSource.get_token();
+    // the thread holds its own entry, so one left detached at exit never points at freed memory
+    managed->thread = std::thread([this, managed, options = std::move(options), body = std::move(body), token] {
+        applyOptions(options);
+        body(token);
+
+        {
+            std::lock_guard lock(m_mutex);
+            managed->finished = true;
+        }
+        m_finishedCondition.notify_all();
+    });
+
+    m_threads.push_back(std::move(managed));
+}
+
+// Threads that already returned on their own are joined the next time something is spawned.
+void ThreadRegistry::reapFinished() {
+    for (auto iter = m_threads.begin(); iter != m_threads.end();) {
+        if ((*iter)->finished) {
+            (*iter)->thread.join();
+            iter = m_threads.erase(iter);
+        }
+        else ++iter;
+    }
+}
+
+/*
+    Asks every thread to stop and waits for them, up to the timeout. A thread stuck past that is left
+    detached rather than holding up the game closing, and is named so it can be tracked down.
+*/
+void ThreadRegistry::stopAll(std::chrono::milliseconds timeout) {
+    std::vector<std::string> stuck;
+
+    std::unique_lock lock(m_mutex);
+    m_stopping = true;
+
+    for (const auto& managed : m_threads) {
+        managed->stopSource.request_stop();
+    }
+
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    m_finishedCondition.wait_until(lock, deadline, [this] {
+        for (const auto& managed : m_threads) {
+            if (!managed->finished) return false;
+        }
+        return true;
+    });
+
+    for (const auto& managed : m_threads) {
+        if (managed->finished) {
+            managed->thread.join();
+        }
+        else {
+            stuck.push_back(managed->name);
+            managed->thread.detach();
+        }
+    }
+    m_threads.clear();
+    lock.unlock();
+
+    // logged after unlocking since a warning can itself spawn a thread, see Console::requestOpen
+    for (const auto& name : stuck) {
+        log::warn("Thread {} did not stop in time", name);
+    }
+}
+
+bool ThreadRegistry::sleepFor(std::stop_token token, std::chrono::milliseconds duration) {
+    std::mutex mutex;
+    std::condition_variable_any condition;
+    std::unique_lock lock(mutex);
+    condition.wait_for(lock, token, duration, [] { return false; });
+    return token.stop_requested();
+}
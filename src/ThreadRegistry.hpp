@@ -0,0 +1,60 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <stop_token>
+#include <string>
+#include <thread>
+#include <vector>
+
+enum class ThreadPriority {
+    // for threads that have to keep up even when the game is busy
+    Normal,
+    Background,
+    Low,
+    Idle
+};
+
+struct ThreadOptions {
+    std::string name;
+    ThreadPriority priority = ThreadPriority::Background;
+    // only applied to threads below normal priority, see the helper CPUs setting
+    bool useHelperAffinity = true;
+};
+
+struct ManagedThread {
+    std::string name;
+    std::thread thread;
+    std::stop_source stopSource;
+    bool finished = false;
+};
+
+/*
+    Every thread the mod starts goes through here, so they're named, kept out of the render thread's way,
+    and can all be stopped when the game exits. Bodies get a stop token and are expected to check it
+    or wait on it instead of sleeping blindly.
+*/
+class ThreadRegistry {
+public:
+    static ThreadRegistry* get();
+
+    void spawn(ThreadOptions&& options, std::function<void(std::stop_token)>&& body);
+    void stopAll(std::chrono::milliseconds timeout);
+
+    // Sleeps unless a stop is requested first, returns whether it was.
+    static bool sleepFor(std::stop_token token, std::chrono::milliseconds duration);
+
+private:
+    static void applyOptions(const ThreadOptions& options);
+    void reapFinished();
+
+    std::list<std::shared_ptr<ManagedThread>> m_threads;
+    std::mutex m_mutex;
+    std::condition_variable m_finishedCondition;
+    bool m_stopping = false;
+};
@@ -0,0 +1,185 @@
+#include <Geode/Geode.hpp>
+#include "Trace.hpp"
+#include "Config.hpp"
+
+using namespace geode::prelude;
+
+std::atomic<bool> Trace::s_enabled = false;
+
+Trace* Trace::get() {
+    static Trace instance;
+    return &instance;
+}
+
+long long Trace::now() {
+    static auto start = std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+void Trace::setEnabled(bool enabled) {
+    if (enabled == isEnabled()) return;
+
+    if (enabled) m_generation.fetch_add(1, std::memory_order_release);
+
+    s_enabled.store(enabled, std::memory_order_relaxed);
+
+    if (!enabled) {
+        auto path = exportJson();
+        if (!path.empty()) log::info("Exported trace to {}", path);
+    }
+}
+
+// Hands the buffer back once its thread exits, so short lived threads don't each leave one behind.
+struct TraceBufferLease {
+    TraceBuffer* buffer = nullptr;
+
+    ~TraceBufferLease() {
+        if (buffer) Trace::get()->releaseBuffer(buffer);
+    }
+};
+
+TraceBuffer* Trace::getThreadBuffer() {
+    thread_local TraceBufferLease lease;
+    if (lease.buffer) return lease.buffer;
+
+    // reset under the lock, the exporter reads other threads' buffers while holding it
+    std::lock_guard lock(m_buffersMutex);
+    if (m_freeBuffers.empty()) {
+        m_buffers.push_back(std::make_unique<TraceBuffer>());
+        lease.buffer = m_buffers.back().get();
+    }
+    else {
+        lease.buffer = m_freeBuffers.back();
+        m_freeBuffers.pop_back();
+    }
+
+    lease.buffer->threadId = GetCurrentThreadId();
+    lease.buffer->size.store(0, std::memory_order_relaxed);
+    lease.buffer->dropped.store(0, std::memory_order_relaxed);
+    lease.buffer->generation.store(m_generation.load(std::memory_order_acquire), std::memory_order_relaxed);
+    return lease.buffer;
+}
+
+void Trace::releaseBuffer(TraceBuffer* buffer) {
+    std::lock_guard lock(m_buffersMutex);
+    m_freeBuffers.push_back(buffer);
+}
+
+void Trace::record(const TraceEvent& event) {
+    auto buffer = getThreadBuffer();
+
+    auto generation = m_generation.load(std::memory_order_acquire);
+    if (buffer->generation.load(std::memory_order_relaxed) != generation) {
+        buffer->size.store(0, std::memory_order_relaxed);
+        buffer->dropped.store(0, std::memory_order_relaxed);
+        buffer->generation.store(generation, std::memory_order_release);
+    }
+
+    auto index = buffer->size.load(std::memory_order_relaxed);
+    if (index >= TraceBuffer::CAPACITY) {
+        buffer->dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    buffer->events[index] = event;
+    buffer->size.store(index + 1, std::memory_order_release);
+}
+
+void Trace::instant(const char* name, const char* category, std::string_view detail) {
+    if (!isEnabled()) return;
+
+    TraceEvent event;
+    event.name = name;
+    event.category = category;
+    event.phase = 'i';
+    event.timestamp = now();
+    event.setDetail(detail);
+    record(event);
+}
+
+void Trace::complete(const char* name, const char* category, std::chrono::steady_clock::time_point start, std::string_view detail) {
+    if (!isEnabled()) return;
+
+    auto duration = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+
+    TraceEvent event;
+    event.name = name;
+    event.category = category;
+    event.timestamp = now() - duration;
+    event.duration = duration;
+    event.setDetail(detail);
+    record(event);
+}
+
+static void appendEscaped(std::string& out, std::string_view str) {
+    for (char c : str) {
+        switch (c) {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) out += fmt::format("\\u{:04x}", c);
+                else out += c;
+                break;
+        }
+    }
+}
+
+/*
+    Writes the Chrome trace event format, which both chrome://tracing and ui.perfetto.dev can open.
+*/
+std::filesystem::path Trace::exportJson() {
+    std::string json = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    bool first = true;
+    size_t dropped = 0;
+    auto pid = GetCurrentProcessId();
+    auto generation = m_generation.load(std::memory_order_acquire);
+
+    {
+        std::lock_guard lock(m_buffersMutex);
+        for (const auto& buffer : m_buffers) {
+            // whatever is left from before tracing was last turned on hasn't been cleared by its thread yet
+            if (buffer->generation.load(std::memory_order_acquire) != generation) continue;
+
+            auto size = buffer->size.load(std::memory_order_acquire);
+            dropped += buffer->dropped.load(std::memory_order_relaxed);
+
+            for (size_t i = 0; i < size; i++) {
+                const auto& event = buffer->events[i];
+                if (!first) json += ",";
+                first = false;
+
+                json += "{\"name\":\"";
+                appendEscaped(json, event.name);
+                json += "\",\"cat\":\"";
+                appendEscaped(json, event.category);
+                json += fmt::format("\",\"ph\":\"{}\",\"ts\":{},\"pid\":{},\"tid\":{}", event.phase, event.timestamp, pid, buffer->threadId);
+
+                if (event.phase == 'X') json += fmt::format(",\"dur\":{}", event.duration);
+                else json += ",\"s\":\"t\"";
+
+                if (event.detail[0]) {
+                    json += ",\"args\":{\"detail\":\"";
+                    appendEscaped(json, event.detail.data());
+                    json += "\"}";
+                }
+                json += "}";
+            }
+        }
+    }
+
+    json += "]}";
+
+    if (first) return {};
+    if (dropped > 0) log::warn("Trace buffers were full, {} events were dropped", dropped);
+
+    auto nowMs = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+    auto path = Config::get()->getUniquePath() / fmt::format("trace-{}.json", nowMs);
+
+    auto res = utils::file::writeString(path, json);
+    if (!res) {
+        log::error("Failed to export trace: {}", res.unwrapErr());
+        return {};
+    }
+
+    return path;
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <vector>
+
+struct TraceEvent {
+    const char* name = nullptr;
+    const char* category = nullptr;
+    char phase = 'X';
+    long long timestamp = 0;
+    long long duration = 0;
+    std::array<char, 48> detail{};
+
+    // cut back to a whole UTF-8 character, half of one would make the exported JSON invalid
+    void setDetail(std::string_view str) {
+        auto size = std::min(str.size(), detail.size() - 1);
+        while (size > 0 && size < str.size() && (static_cast<uint8_t>(str[size]) & 0xC0) == 0x80) size--;
+        std::copy_n(str.data(), size, detail.data());
+    }
+};
+
+/*
+    Each thread only ever writes to its own buffer, so recording is a plain store followed by a release
+    of the new size. The exporter reads up to the published size. Once a buffer is full, events are dropped.
+    Turning tracing back on starts a new generation, and each thread empties its own buffer the next time it
+    records, since resetting it from another thread could race with a write that's already under way.
+*/
+struct TraceBuffer {
+    static constexpr size_t CAPACITY = 16384;
+
+    std::array<TraceEvent, CAPACITY> events;
+    std::atomic<size_t> size = 0;
+    std::atomic<size_t> dropped = 0;
+    std::atomic<uint64_t> generation = 0;
+    unsigned long threadId = 0;
+};
+
+class Trace {
+public:
+    static Trace* get();
+
+    static bool isEnabled() {
+        return s_enabled.load(std::memory_order_relaxed);
+    }
+
+    static long long now();
+
+    void setEnabled(bool enabled);
+    void record(const TraceEvent& event);
+    void instant(const char* name, const char* category, std::string_view detail = {});
+    void complete(const char* name, const char* category, std::chrono::steady_clock::time_point start, std::string_view detail = {});
+    std::filesystem::path exportJson();
+
+private:
+    friend struct TraceBufferLease;
+
+    TraceBuffer* getThreadBuffer();
+    void releaseBuffer(TraceBuffer* buffer);
+
+    std::vector<std::unique_ptr<TraceBuffer>> m_buffers;
+    // buffers whose thread has exited, their events stay exportable until another thread takes them over
+    std::vector<TraceBuffer*> m_freeBuffers;
+    std::mutex m_buffersMutex;
+    std::atomic<uint64_t> m_generation = 0;
+
+    static std::atomic<bool> s_enabled;
+};
+
+// Records a complete event covering its scope. When tracing is disabled this is a single relaxed load.
+class TraceSpan {
+public:
+    TraceSpan(const char* name, const char* category, std::string_view detail = {}) {
+        if (!Trace::isEnabled()) return;
+        m_event.name = name;
+        m_event.category = category;
+        m_event.timestamp = Trace::now();
+        m_event.setDetail(detail);
+        m_active = true;
+    }
+
+    ~TraceSpan() {
+        if (!m_active) return;
+        m_event.duration = Trace::now() - m_event.timestamp;
+        Trace::get()->record(m_event);
+    }
+
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+
+private:
+    TraceEvent m_event;
+    bool m_active = false;
+};
@@ -1,8 +1,10 @@
 #pragma once
 
 #include "Config.hpp"
+#include "Trace.hpp"
 #include <Geode/loader/Log.hpp>
 #include <Geode/loader/Types.hpp>
+#include <algorithm>
 #include <filesystem>
 #include <minwindef.h>
 #include <processthreadsapi.h>
@@ -24,6 +26,15 @@ namespace sobriety::utils {
         return geode::Severity::Info;
     }
 
+    static std::string_view toString(geode::Severity severity) {
+        switch (severity) {
+            case geode::Severity::Debug: return "debug";
+            case geode::Severity::Warning: return "warning";
+            case geode::Severity::Error: return "error";
+            default: return "info";
+        }
+    }
+
     static void createTempDir() {
         auto path = Config::get()->getUniquePath();
         if (!std::filesystem::exists(path)) {
@@ -32,7 +43,9 @@ namespace sobriety::utils {
         }
     }
 
-    static void runCommand(const std::string& cmd) {
+    static bool runCommand(const std::string& cmd) {
+        TraceSpan span("runCommand", "process", cmd);
+
         STARTUPINFOA si{};
         PROCESS_INFORMATION pi{};
 
@@ -51,10 +64,12 @@ namespace sobriety::utils {
                 &si,
                 &pi
             )) {
-        } else {
-            CloseHandle(pi.hProcess);
-            CloseHandle(pi.hThread);
+            return false;
         }
+
+        CloseHandle(pi.hProcess);
+        CloseHandle(pi.hThread);
+        return true;
     }
 
     static bool isWine() {
@@ -118,4 +133,93 @@ namespace sobriety::utils {
 
         return fullPath;
     }
-}
\ No newline at end of file
+
+    /*
+        Matches a path relative to a watched directory against a glob, both using forward slashes.
+        * and ? stay within one path component, ** crosses them, and a ** followed by a slash at the start
+        of a component can also match nothing. Only the last * and ** are ever retried, so a pattern like
+        a*a*a*b takes time proportional to the pattern times the path rather than blowing up.
+    */
+    static bool globMatch(std::string_view pattern, std::string_view path) {
+        size_t p = 0;
+        size_t s = 0;
+
+        // where the last * and ** started, a mismatch goes back there and lets them take more
+        size_t starP = std::string_view::npos;
+        size_t starS = 0;
+        size_t globP = std::string_view::npos;
+        size_t globS = 0;
+        bool globFolders = false;
+
+        while (true) {
+            if (p < pattern.size()) {
+                if (pattern.substr(p).starts_with("**")) {
+                    globFolders = (p == 0 || pattern[p - 1] == '/') && pattern.substr(p + 2).starts_with('/');
+                    p += globFolders ? 3 : 2;
+                    globP = p;
+                    globS = s;
+                    starP = std::string_view::npos;
+                    continue;
+                }
+                if (pattern[p] == '*') {
+                    starP = ++p;
+                    starS = s;
+                    continue;
+                }
+                if (s < path.size() && (pattern[p] == path[s] || (pattern[p] == '?' && path[s] != '/'))) {
+                    p++;
+                    s++;
+                    continue;
+                }
+            }
+            else if (s == path.size()) return true;
+
+            // a * takes one more character, as long as it stays within its folder
+            if (starP != std::string_view::npos && starS < path.size() && path[starS] != '/') {
+                p = starP;
+                s = ++starS;
+                continue;
+            }
+
+            // otherwise the ** does, a whole folder at a time when it's a **/ of its own
+            if (globP == std::string_view::npos) return false;
+            if (globFolders) {
+                auto slash = path.find('/', globS);
+                if (slash == std::string_view::npos) return false;
+                globS = slash + 1;
+            }
+            else {
+                if (globS == path.size()) return false;
+                globS++;
+            }
+            p = globP;
+            s = globS;
+            starP = std::string_view::npos;
+        }
+    }
+
+    // Turns a list like "0-1,4" into an affinity mask, anything that doesn't parse is skipped.
+    static uint64_t parseCpuList(std::string_view list) {
+        uint64_t mask = 0;
+        for (auto part : geode::utils::string::split(std::string(list), ",")) {
+            geode::utils::string::trimIP(part);
+            if (part.empty()) continue;
+
+            auto dash = part.find('-');
+            auto firstRes = geode::utils::numFromString<int>(part.substr(0, dash));
+            auto lastRes = dash == std::string::npos ? firstRes : geode::utils::numFromString<int>(part.substr(dash + 1));
+            if (!firstRes || !lastRes) continue;
+
+            for (int cpu = std::max(firstRes.unwrap(), 0); cpu <= std::min(lastRes.unwrap(), 63); cpu++) {
+                mask |= uint64_t{1} << cpu;
+            }
+        }
+        return mask;
+    }
+
+    static std::string formatBytes(uint64_t bytes) {
+        if (bytes >= 1024 * 1024) return fmt::format("{:.1f} MiB", bytes / (1024.0 * 1024.0));
+        if (bytes >= 1024) return fmt::format("{:.1f} KiB", bytes / 1024.0);
+        return fmt::format("{} B", bytes);
+    }
+}
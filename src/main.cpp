@@ -1,19 +1,47 @@
 #include <Geode/Geode.hpp>
 #include "Config.hpp"
 #include "FileExplorer.hpp"
+#include "FrameProfiler.hpp"
+#include "LogArchive.hpp"
+#include "LogVolume.hpp"
+#include "PerformanceOverlay.hpp"
 #include "Console.hpp"
+#include "SessionCollector.hpp"
+#include "SpawnBroker.hpp"
+#include "StallDetector.hpp"
+#include "Startup.hpp"
+#include "ThreadRegistry.hpp"
+#include "Trace.hpp"
 #include "Utils.hpp"
 
 using namespace geode::prelude;
 
 void setupEvents() {
     GameEvent(GameEventType::Exiting).listen([] {
-        auto exitPath = Config::get()->getUniquePath() / "console.exit";
-        auto exitRes = utils::file::writeString(exitPath, "");
-        if (!exitRes) return log::error("Failed to create console exit file");
+        SpawnBroker::get()->shutdown();
+
+        for (const auto& line : LogVolume::get()->report(5)) log::info("{}", line);
+
+        if (Trace::isEnabled()) {
+            auto path = Trace::get()->exportJson();
+            if (!path.empty()) log::info("Exported trace to {}", path);
+        }
+
+        if (Config::get()->shouldArchiveConsole()) {
+            auto archiveRes = LogArchive::get()->exportArchive();
+            if (archiveRes) log::info("Exported console archive to {}", archiveRes.unwrap());
+            else log::error("Failed to export console archive: {}", archiveRes.unwrapErr());
+        }
+
+        Console::get()->close();
+
+        // last, so the sinks get to write out anything logged above
+        ThreadRegistry::get()->stopAll(std::chrono::milliseconds(500));
     }).leak();
 
     GameEvent(GameEventType::Loaded).listen([] {
+        PerformanceOverlay::setEnabled(Config::get()->showPerformanceOverlay());
+
         if (!sobriety::utils::isWine()) {
             createQuickPopup("Windows User Detected!", "Sobriety only works on <cg>Linux</c> systems and will do nothing on <cb>Windows</c>.\nIt has been <cr>uninstalled</c>.", "OK", nullptr, nullptr);
         }
@@ -22,9 +50,26 @@ void setupEvents() {
 
 $on_mod(Loaded) {
     if (sobriety::utils::isWine()) {
-        FileExplorer::get()->setup();
-        Console::get()->setup();
-        setupEvents();
+        auto startup = Startup::get();
+
+        // Only what has to exist before the game continues loading is done here
+        startup->measure("config", [] { Config::get(); });
+        startup->measure("trace", [] { Trace::get()->setEnabled(Config::get()->isTraceEnabled()); });
+        startup->measure("hooks", [] { FileExplorer::get()->setupHooks(); });
+        startup->measure("log listener", [] { Console::get()->setupEvents(); });
+        startup->measure("game events", setupEvents);
+        startup->measure("stall detector", [] { StallDetector::get()->setup(); });
+        startup->measure("frame profiler", [] { FrameProfiler::get()->setup(); });
+
+        ThreadRegistry::get()->spawn({ .name = "deferred startup", .priority = ThreadPriority::Normal }, [startup](std::stop_token) {
+            startup->measure("temp directory", sobriety::utils::createTempDir, true);
+            startup->measure("session collector", [] { SessionCollector::get()->setup(); }, true);
+            startup->measure("spawn broker", [] { SpawnBroker::get()->setup(); }, true);
+            startup->measure("file explorer", [] { FileExplorer::get()->setup(); }, true);
+            startup->measure("console", [] { Console::get()->setup(); }, true);
+            startup->measure("archive restore", LogArchive::restoreArchives, true);
+            startup->report();
+        });
         return;
     }
     (void) Mod::get()->uninstall();